@@ -0,0 +1,230 @@
+// Headless batch simulator: parses, plans and estimates G-code files without a window
+// or an OpenGL context and prints the statistics as JSON.
+//
+// Usage: BatchSim [--profile printer.ini] [--steps] [--step-events events.csv] [--from-layer N]
+//                 [--check-limits] [--threads N] file.gcode [file.gcode ...]
+//        BatchSim --farm farm.txt [--threads N]
+//        BatchSim --replay-jog jog.bin [--jog-gcode out.gcode] [--profile printer.ini]
+
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<iostream>
+#include<memory>
+#include<sstream>
+#include<vector>
+
+#include"Farm.h"
+#include"JogLog.h"
+#include"PrinterProfile.h"
+#include"Simulator.h"
+#include"ThreadPool.h"
+
+static void printUsage()
+{
+	std::cerr << "Usage: BatchSim [--profile printer.ini] [--steps] [--step-events events.csv] [--from-layer N]" << std::endl;
+	std::cerr << "                [--check-limits] [--threads N] file.gcode [file.gcode ...]" << std::endl;
+	std::cerr << "       BatchSim --farm farm.txt [--threads N]" << std::endl;
+	std::cerr << "       BatchSim --replay-jog jog.bin [--jog-gcode out.gcode] [--profile printer.ini]" << std::endl;
+}
+
+// Replays a jog session recorded in the viewer, turns it into G-code and simulates that like any other job
+static int replayJog(const char* logFile, const char* gcodeFile, const PrinterProfile& profile)
+{
+	JogLog log;
+	if (!readJogLog(logFile, log))
+	{
+		std::cerr << "Failed to read jog log " << logFile << std::endl;
+		return 2;
+	}
+
+	std::vector<glm::vec3> positions;
+	replayJogLog(log, positions);
+	float pathLength = 0.0f;
+	glm::vec3 previous = log.start;
+	for (const glm::vec3& position : positions)
+	{
+		pathLength += glm::length(position - previous);
+		previous = position;
+	}
+
+	std::ostringstream gcode;
+	writeJogGcode(gcode, log);
+	if (gcodeFile != NULL)
+	{
+		std::ofstream out(gcodeFile);
+		if (!out || !(out << gcode.str()))
+		{
+			std::cerr << "Failed to write " << gcodeFile << std::endl;
+			return 2;
+		}
+	}
+
+	SimulationJob job;
+	simulateGcode(gcode.str(), profile, job);
+
+	uint64_t ticks = log.tickCount();
+	std::cout << "{\"jog_log\": " << jsonString(logFile) << ", \"ticks\": " << ticks
+		<< ", \"runs\": " << log.runs.size() << ", \"moving_ticks\": " << positions.size()
+		<< ", \"recorded_s\": " << (log.ticksPerSecond > 0.0f ? ticks / log.ticksPerSecond : 0.0f)
+		<< ", \"end\": [" << previous.x << ", " << previous.y << ", " << previous.z << "]"
+		<< ", \"path_length\": " << pathLength << ",\n \"job\": ";
+	writeJobJson(std::cout, gcodeFile != NULL ? gcodeFile : "jog", job);
+	std::cout << "}" << std::endl;
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	PrinterProfile profile;
+	std::vector<const char*> files;
+	const char* farmFile = NULL;
+	const char* jogFile = NULL;
+	const char* jogGcodeFile = NULL;
+	unsigned threads = 0;
+	SimulationOptions options;
+	const char* stepEventsFile = NULL;
+	// Layer to restart the jobs from, -1 simulates them from the start
+	int fromLayer = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			if (!loadPrinterProfile(argv[++i], profile))
+				return 2;
+		}
+		else if (strcmp(argv[i], "--steps") == 0)
+		{
+			options.steps = true;
+		}
+		else if (strcmp(argv[i], "--step-events") == 0 && i + 1 < argc)
+		{
+			options.steps = true;
+			stepEventsFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--from-layer") == 0 && i + 1 < argc)
+		{
+			fromLayer = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--check-limits") == 0)
+		{
+			options.limits = true;
+		}
+		else if (strcmp(argv[i], "--farm") == 0 && i + 1 < argc)
+		{
+			farmFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay-jog") == 0 && i + 1 < argc)
+		{
+			jogFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--jog-gcode") == 0 && i + 1 < argc)
+		{
+			jogGcodeFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = (unsigned)atoi(argv[++i]);
+		}
+		else if (argv[i][0] == '-' && argv[i][1] == '-')
+		{
+			printUsage();
+			return 2;
+		}
+		else
+		{
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (farmFile != NULL)
+	{
+		FarmConfig config;
+		if (!loadFarmConfig(farmFile, config))
+			return 2;
+		ThreadPool pool(threads);
+		FarmResult result;
+		simulateFarm(config, pool, result);
+		writeFarmJson(std::cout, config, result);
+		std::cout << std::endl;
+		return result.failedJobs.empty() ? 0 : 1;
+	}
+
+	if (jogFile != NULL)
+		return replayJog(jogFile, jogGcodeFile, profile);
+
+	if (files.empty())
+	{
+		printUsage();
+		return 2;
+	}
+
+	// Step pulses of the moves over the step budget, for a closer look at where a job stutters
+	std::ofstream stepEvents;
+	if (stepEventsFile != NULL)
+	{
+		stepEvents.open(stepEventsFile);
+		if (!stepEvents)
+		{
+			std::cerr << "Failed to create " << stepEventsFile << std::endl;
+			return 2;
+		}
+		stepEvents << "file,line,time_s,motor,direction\n";
+	}
+
+	// The limit check splits every job across the cores
+	std::unique_ptr<ThreadPool> pool;
+	if (options.limits)
+	{
+		pool.reset(new ThreadPool(threads));
+		options.pool = pool.get();
+	}
+
+	int result = 0;
+	SimulationJob job;
+	job.options = options;
+	std::string gcode;
+	std::cout << "{\"profile\": " << jsonString(profile.name) << ", \"jobs\": [";
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::cout << (i == 0 ? "\n  " : ",\n  ");
+		if (!readTextFile(files[i], gcode))
+		{
+			std::cerr << "Failed to read " << files[i] << std::endl;
+			std::cout << "{\"file\": " << jsonString(files[i]) << ", \"error\": \"cannot read file\"}";
+			result = 1;
+			continue;
+		}
+		// A restarted job is simulated and reported only from the layer on
+		if (fromLayer < 0)
+		{
+			simulateGcode(gcode, profile, job);
+		}
+		else if (!simulateFromLayer(gcode, profile, (size_t)fromLayer, job))
+		{
+			std::cerr << files[i] << " has no layer " << fromLayer << std::endl;
+			std::cout << "{\"file\": " << jsonString(files[i]) << ", \"error\": \"no such layer\"}";
+			result = 1;
+			continue;
+		}
+		writeJobJson(std::cout, files[i], job);
+
+		if (stepEvents.is_open())
+		{
+			std::vector<StepEvent> events;
+			for (const StepRateViolation& violation : job.stepStats.violations)
+			{
+				events.clear();
+				generateStepEvents(job.plan, job.steps, violation.move, events);
+				for (const StepEvent& event : events)
+				{
+					stepEvents << files[i] << "," << violation.line << "," << event.time << ","
+						<< motorName(job.kinematics, event.motor) << "," << (int)event.direction << "\n";
+				}
+			}
+		}
+	}
+	std::cout << "\n]}" << std::endl;
+	return result;
+}
@@ -0,0 +1,34 @@
+#include"BedGrid.h"
+
+// Constructor that generates the VAO
+BedGrid::BedGrid()
+{
+	glGenVertexArrays(1, &vaoID);
+}
+
+// Sets the bed the grid covers, once or whenever the bed changes
+void BedGrid::SetBed(Shader& shader, const glm::vec3& bedMin, const glm::vec3& bedMax)
+{
+	shader.Activate();
+	glUniform3f(glGetUniformLocation(shader.ID, "bedMin"), bedMin.x, bedMin.y, bedMin.z);
+	glUniform3f(glGetUniformLocation(shader.ID, "bedMax"), bedMax.x, bedMax.y, bedMax.z);
+}
+
+// Draws the grid with the grid shader, blending has to be on with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+void BedGrid::Draw(Shader& shader, Camera& camera)
+{
+	shader.Activate();
+	camera.Matrix(shader, "camMatrix");
+
+	// The lines fade out at their edges with the caller's alpha blending, the rest of the quad is
+	// discarded and leaves the depth alone
+	glBindVertexArray(vaoID);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(0);
+}
+
+// Deletes the VAO
+void BedGrid::Delete()
+{
+	glDeleteVertexArrays(1, &vaoID);
+}
@@ -0,0 +1,29 @@
+#ifndef BED_GRID_CLASS_H
+#define BED_GRID_CLASS_H
+
+#include<glm/glm.hpp>
+#include<glad/glad.h>
+
+#include"Camera.h"
+#include"shaderClass.h"
+
+// Grid over the bed drawn by grid.vert and grid.frag. The quad's corners come from gl_VertexID and the
+// lines from the fragment position, so drawing it uploads nothing and the VAO holds no buffers.
+class BedGrid
+{
+public:
+	// ID reference of the empty Vertex Array Object the core profile needs for drawing
+	GLuint vaoID;
+
+	// Constructor that generates the VAO
+	BedGrid();
+
+	// Sets the bed the grid covers, once or whenever the bed changes
+	void SetBed(Shader& shader, const glm::vec3& bedMin, const glm::vec3& bedMax);
+	// Draws the grid with the grid shader, blending has to be on with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+	void Draw(Shader& shader, Camera& camera);
+	// Deletes the VAO
+	void Delete();
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include"Checkpoint.h"
+
+#include<algorithm>
+#include<cstring>
+
+// Checkpoint right before the first move of a layer, NULL if the layer does not exist
+const Checkpoint* CheckpointTable::atLayer(size_t layer) const
+{
+	auto first = std::lower_bound(checkpoints.begin(), checkpoints.end(), layer,
+		[](const Checkpoint& checkpoint, size_t value) { return checkpoint.layers < value; });
+	for (auto it = first; it != checkpoints.end() && it->layers == layer; ++it)
+	{
+		if (it->startsLayer)
+			return &*it;
+	}
+	return NULL;
+}
+
+// Last checkpoint before the line that made a move, NULL if the table is empty
+const Checkpoint* CheckpointTable::beforeMove(size_t move) const
+{
+	auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), move,
+		[](size_t value, const Checkpoint& checkpoint) { return value < checkpoint.move; });
+	return after == checkpoints.begin() ? NULL : &*(after - 1);
+}
+
+// Parses a whole program like GcodeParser::parse and records checkpoints along the way
+void parseWithCheckpoints(GcodeParser& parser, const char* text, size_t length, Toolpath& toolpath, CheckpointTable& table,
+	size_t stopLayer)
+{
+	toolpath.reserve(toolpath.size() + length / 24);
+
+	// The state before every line is kept until the line shows whether it started a layer
+	Checkpoint pending;
+	const char* end = text + length;
+	const char* lineBegin = text;
+	while (lineBegin < end)
+	{
+		const char* lineEnd = (const char*)memchr(lineBegin, '\n', end - lineBegin);
+		if (lineEnd == NULL)
+			lineEnd = end;
+
+		pending.offset = lineBegin - text;
+		pending.move = toolpath.size();
+		pending.layers = toolpath.layerStart.size();
+		pending.parser = parser.saveState();
+		parser.parseLine(lineBegin, lineEnd, toolpath);
+
+		pending.startsLayer = toolpath.layerStart.size() != pending.layers;
+		if (table.checkpoints.empty() || pending.startsLayer)
+			table.checkpoints.push_back(pending);
+		if (pending.startsLayer && pending.layers == stopLayer)
+			break;
+		lineBegin = lineEnd + 1;
+	}
+}
+
+// Copies the planned time and entry speed into the checkpoints
+void timeCheckpoints(const MotionPlan& plan, CheckpointTable& table)
+{
+	for (Checkpoint& checkpoint : table.checkpoints)
+	{
+		checkpoint.time = checkpoint.move < plan.size() ? plan.startTime(checkpoint.move) : plan.totalTime;
+		checkpoint.entrySpeed = checkpoint.move < plan.size() ? plan.entrySpeed[checkpoint.move] : 0.0f;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_CLASS_H
+#define CHECKPOINT_CLASS_H
+
+#include<cstdint>
+#include<vector>
+
+#include"Gcode.h"
+#include"Planner.h"
+
+// Machine state right before a line of the program, enough to restart the simulation there
+struct Checkpoint
+{
+	// Byte offset of the line in the program text
+	size_t offset;
+	// Moves and layers already in the toolpath at that point
+	size_t move;
+	size_t layers;
+	// Set when the line starts layer number layers, the first checkpoint may not
+	bool startsLayer;
+	ParserState parser;
+	// Planner state: time since the job started and the speed the next move is entered with
+	double time = 0.0;
+	float entrySpeed = 0.0f;
+};
+
+// One checkpoint at the start of the program and one at the start of every layer, sorted by move
+struct CheckpointTable
+{
+	std::vector<Checkpoint> checkpoints;
+
+	size_t size() const { return checkpoints.size(); }
+	void clear() { checkpoints.clear(); }
+	// Checkpoint right before the first move of a layer, NULL if the layer does not exist
+	const Checkpoint* atLayer(size_t layer) const;
+	// Last checkpoint before the line that made a move, NULL if the table is empty
+	const Checkpoint* beforeMove(size_t move) const;
+};
+
+// Parses a whole program like GcodeParser::parse and records checkpoints along the way.
+// With a stopLayer the parse ends right after the checkpoint of that layer.
+void parseWithCheckpoints(GcodeParser& parser, const char* text, size_t length, Toolpath& toolpath, CheckpointTable& table,
+	size_t stopLayer = SIZE_MAX);
+// Copies the planned time and entry speed into the checkpoints
+void timeCheckpoints(const MotionPlan& plan, CheckpointTable& table);
+
+#endif
@@ -0,0 +1,65 @@
+#include"ColorLut.h"
+
+#include<algorithm>
+
+// Constructor that uploads the colors, smooth tables blend between neighbouring colors,
+// the others keep every color over its own slice of 0..1
+ColorLut::ColorLut(const std::vector<glm::vec4>& colors, bool smooth, GLuint slot)
+{
+	std::vector<unsigned char> texels(colors.size() * 4);
+	for (size_t i = 0; i < colors.size(); i++)
+	{
+		for (int c = 0; c < 4; c++)
+			texels[4 * i + c] = (unsigned char)(glm::clamp(colors[i][c], 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	glGenTextures(1, &ID);
+	glActiveTexture(GL_TEXTURE0 + slot);
+	unit = slot;
+	glBindTexture(GL_TEXTURE_1D, ID);
+
+	// Values past the ends keep the end colors
+	GLint filter = smooth ? GL_LINEAR : GL_NEAREST;
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, (GLsizei)colors.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+// Binds the texture to its unit
+void ColorLut::Bind()
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_1D, ID);
+}
+
+// Unbinds the texture
+void ColorLut::Unbind()
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+// Deletes the texture
+void ColorLut::Delete()
+{
+	glDeleteTextures(1, &ID);
+}
+
+// size colors blended evenly through the given stops
+std::vector<glm::vec4> colorGradient(const std::vector<glm::vec4>& stops, size_t size)
+{
+	std::vector<glm::vec4> colors(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		float t = size > 1 ? (float)i / (size - 1) * (stops.size() - 1) : 0.0f;
+		size_t stop = std::min((size_t)t, stops.size() - 2);
+		colors[i] = glm::mix(stops[stop], stops[stop + 1], t - stop);
+	}
+	return colors;
+}
@@ -0,0 +1,33 @@
+#ifndef COLOR_LUT_CLASS_H
+#define COLOR_LUT_CLASS_H
+
+#include<vector>
+
+#include<glm/glm.hpp>
+#include<glad/glad.h>
+
+// 1D lookup texture the toolpath shader maps a color value of 0..1 through
+class ColorLut
+{
+public:
+	// ID reference of the texture
+	GLuint ID;
+	// Texture unit the table is bound to
+	GLuint unit;
+
+	// Constructor that uploads the colors, smooth tables blend between neighbouring colors,
+	// the others keep every color over its own slice of 0..1
+	ColorLut(const std::vector<glm::vec4>& colors, bool smooth, GLuint slot);
+
+	// Binds the texture to its unit
+	void Bind();
+	// Unbinds the texture
+	void Unbind();
+	// Deletes the texture
+	void Delete();
+};
+
+// size colors blended evenly through the given stops
+std::vector<glm::vec4> colorGradient(const std::vector<glm::vec4>& stops, size_t size);
+
+#endif
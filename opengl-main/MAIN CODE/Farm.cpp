@@ -0,0 +1,310 @@
+#include"Farm.h"
+
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<filesystem>
+#include<fstream>
+#include<iomanip>
+#include<iostream>
+#include<map>
+#include<sstream>
+
+namespace fs = std::filesystem;
+
+// True for tokens that are plain non-negative integers
+static bool isCount(const std::string& token)
+{
+	return !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// Resolves a path from the farm file against the farm file's directory
+static std::string resolvePath(const fs::path& base, const std::string& path)
+{
+	fs::path resolved(path);
+	if (resolved.is_relative())
+		resolved = base / resolved;
+	return resolved.string();
+}
+
+// Reads a farm description, see Farm.h for the format
+bool loadFarmConfig(const char* filename, FarmConfig& config)
+{
+	std::ifstream in(filename);
+	if (!in)
+	{
+		std::cerr << "Failed to open farm file " << filename << std::endl;
+		return false;
+	}
+	fs::path base = fs::path(filename).parent_path();
+
+	config = FarmConfig();
+	// Printers without a profile file use the defaults
+	config.profiles.push_back(PrinterProfile());
+	config.profileFiles.push_back("");
+
+	std::vector<std::string> pinnedNames;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+
+		size_t equals = line.find('=');
+		if (equals != std::string::npos)
+		{
+			std::istringstream key(line.substr(0, equals));
+			std::string name;
+			key >> name;
+			if (name == "changeover")
+			{
+				config.changeoverTime = atof(line.c_str() + equals + 1);
+				continue;
+			}
+			std::cerr << filename << ":" << lineNumber << ": unknown setting " << name << std::endl;
+			return false;
+		}
+
+		std::istringstream stream(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (stream >> token)
+			tokens.push_back(token);
+		if (tokens.empty())
+			continue;
+
+		if (tokens[0] == "printer" && tokens.size() >= 2)
+		{
+			int profile = 0;
+			int count = 1;
+			for (size_t i = 2; i < tokens.size(); i++)
+			{
+				if (isCount(tokens[i]))
+				{
+					count = atoi(tokens[i].c_str());
+					continue;
+				}
+				std::string path = resolvePath(base, tokens[i]);
+				auto known = std::find(config.profileFiles.begin(), config.profileFiles.end(), path);
+				if (known != config.profileFiles.end())
+				{
+					profile = (int)(known - config.profileFiles.begin());
+					continue;
+				}
+				PrinterProfile loaded;
+				if (!loadPrinterProfile(path.c_str(), loaded))
+					return false;
+				profile = (int)config.profiles.size();
+				config.profiles.push_back(loaded);
+				config.profileFiles.push_back(path);
+			}
+			for (int i = 0; i < count; i++)
+			{
+				FarmPrinter printer;
+				printer.name = count == 1 ? tokens[1] : tokens[1] + "-" + std::to_string(i + 1);
+				printer.profile = profile;
+				config.printers.push_back(printer);
+			}
+		}
+		else if (tokens[0] == "job" && tokens.size() >= 2)
+		{
+			int count = 1;
+			std::string pinned;
+			for (size_t i = 2; i < tokens.size(); i++)
+			{
+				if (isCount(tokens[i]))
+					count = atoi(tokens[i].c_str());
+				else
+					pinned = tokens[i];
+			}
+			FarmJob job;
+			job.file = resolvePath(base, tokens[1]);
+			for (int i = 0; i < count; i++)
+			{
+				config.jobs.push_back(job);
+				pinnedNames.push_back(pinned);
+			}
+		}
+		else
+		{
+			std::cerr << filename << ":" << lineNumber << ": expected printer, job or changeover" << std::endl;
+			return false;
+		}
+	}
+
+	// Jobs may name printers declared further down
+	for (size_t i = 0; i < config.jobs.size(); i++)
+	{
+		if (pinnedNames[i].empty())
+			continue;
+		auto printer = std::find_if(config.printers.begin(), config.printers.end(),
+			[&](const FarmPrinter& candidate) { return candidate.name == pinnedNames[i]; });
+		if (printer == config.printers.end())
+		{
+			std::cerr << filename << ": job " << config.jobs[i].file << " names unknown printer " << pinnedNames[i] << std::endl;
+			return false;
+		}
+		config.jobs[i].printer = (int)(printer - config.printers.begin());
+	}
+
+	if (config.printers.empty())
+	{
+		std::cerr << filename << ": farm has no printers" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Simulates every job on the pool, then dispatches the queue to the printers
+void simulateFarm(const FarmConfig& config, ThreadPool& pool, FarmResult& result)
+{
+	auto wallStart = std::chrono::steady_clock::now();
+	result = FarmResult();
+
+	// Every distinct (file, profile) pair is simulated once, copies of a job reuse it
+	std::map<std::pair<std::string, int>, size_t> programIndex;
+	std::vector<std::pair<std::string, int>> programs;
+	auto requireProgram = [&](const std::string& file, int profile)
+	{
+		auto key = std::make_pair(file, profile);
+		if (programIndex.find(key) == programIndex.end())
+		{
+			programIndex[key] = programs.size();
+			programs.push_back(key);
+		}
+	};
+	for (const FarmJob& job : config.jobs)
+	{
+		if (job.printer >= 0)
+		{
+			requireProgram(job.file, config.printers[job.printer].profile);
+			continue;
+		}
+		for (const FarmPrinter& printer : config.printers)
+			requireProgram(job.file, printer.profile);
+	}
+
+	std::vector<SimulationStats> programStats(programs.size());
+	std::vector<HeatingProgram> programHeating(programs.size());
+	std::vector<char> programFailed(programs.size(), 0);
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		pool.submit([&, i]
+		{
+			SimulationJob job;
+			job.options.heating = false;
+			const PrinterProfile& profile = config.profiles[programs[i].second];
+			if (simulateFile(programs[i].first.c_str(), profile, job))
+			{
+				programStats[i] = job.stats;
+				programHeating[i] = std::move(job.heating);
+			}
+			else
+			{
+				programFailed[i] = 1;
+			}
+		});
+	}
+	pool.wait();
+	result.simulatedPrograms = programs.size();
+
+	// The heaters of all programs are integrated together, a few lanes per printer
+	std::vector<const HeatingProgram*> heatingPrograms;
+	std::vector<const PrinterProfile*> heatingProfiles;
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		heatingPrograms.push_back(&programHeating[i]);
+		heatingProfiles.push_back(&config.profiles[programs[i].second]);
+	}
+	std::vector<HeatingResult> heatingResults;
+	simulateHeating(heatingPrograms, heatingProfiles, heatingResults);
+	for (size_t i = 0; i < programs.size(); i++)
+		addHeating(heatingResults[i], programStats[i]);
+
+	// List scheduling in queue order, every job goes to the printer that finishes it first
+	std::vector<double> printerFree(config.printers.size(), 0.0);
+	result.timelines.resize(config.printers.size());
+	for (size_t j = 0; j < config.jobs.size(); j++)
+	{
+		const FarmJob& job = config.jobs[j];
+		int best = -1;
+		double bestEnd = 0.0;
+		for (size_t p = 0; p < config.printers.size(); p++)
+		{
+			if (job.printer >= 0 && (int)p != job.printer)
+				continue;
+			size_t program = programIndex[std::make_pair(job.file, config.printers[p].profile)];
+			if (programFailed[program])
+				continue;
+			double end = printerFree[p] + programStats[program].printTime;
+			if (best < 0 || end < bestEnd)
+			{
+				best = (int)p;
+				bestEnd = end;
+			}
+		}
+		if (best < 0)
+		{
+			result.failedJobs.push_back(j);
+			continue;
+		}
+
+		size_t program = programIndex[std::make_pair(job.file, config.printers[best].profile)];
+		FarmTimelineEntry entry;
+		entry.job = j;
+		entry.start = printerFree[best];
+		entry.end = bestEnd;
+		result.timelines[best].push_back(entry);
+		result.machineHours += programStats[program].printTime / 3600.0;
+		result.makespan = std::max(result.makespan, entry.end);
+		printerFree[best] = entry.end + config.changeoverTime;
+	}
+
+	result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+// Writes the aggregate numbers and the per-printer timelines as JSON
+void writeFarmJson(std::ostream& out, const FarmConfig& config, const FarmResult& result)
+{
+	out << std::setprecision(9);
+	out << "{\"printers\": " << config.printers.size();
+	out << ", \"jobs\": " << config.jobs.size();
+	out << ", \"simulated_programs\": " << result.simulatedPrograms;
+	out << ", \"makespan_s\": " << result.makespan;
+	out << ", \"machine_hours\": " << result.machineHours;
+	out << ", \"wall_s\": " << result.wallSeconds;
+	out << ", \"machine_hours_per_wall_s\": " << (result.wallSeconds > 0.0 ? result.machineHours / result.wallSeconds : 0.0);
+
+	out << ", \"failed_jobs\": [";
+	for (size_t i = 0; i < result.failedJobs.size(); i++)
+		out << (i == 0 ? "" : ", ") << jsonString(config.jobs[result.failedJobs[i]].file);
+	out << "]";
+
+	out << ",\n \"timelines\": [";
+	for (size_t p = 0; p < config.printers.size(); p++)
+	{
+		const std::vector<FarmTimelineEntry>& timeline = result.timelines[p];
+		double busy = 0.0;
+		for (const FarmTimelineEntry& entry : timeline)
+			busy += entry.end - entry.start;
+
+		out << (p == 0 ? "\n  " : ",\n  ");
+		out << "{\"printer\": " << jsonString(config.printers[p].name);
+		out << ", \"profile\": " << jsonString(config.profiles[config.printers[p].profile].name);
+		out << ", \"busy_s\": " << busy;
+		out << ", \"utilization\": " << (result.makespan > 0.0 ? busy / result.makespan : 0.0);
+		out << ", \"jobs\": [";
+		for (size_t i = 0; i < timeline.size(); i++)
+		{
+			const FarmTimelineEntry& entry = timeline[i];
+			out << (i == 0 ? "" : ", ");
+			out << "{\"job\": " << entry.job << ", \"file\": " << jsonString(config.jobs[entry.job].file);
+			out << ", \"start_s\": " << entry.start << ", \"end_s\": " << entry.end << "}";
+		}
+		out << "]}";
+	}
+	out << "\n]}";
+}
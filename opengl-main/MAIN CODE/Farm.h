@@ -0,0 +1,76 @@
+#ifndef FARM_CLASS_H
+#define FARM_CLASS_H
+
+#include<ostream>
+#include<string>
+#include<vector>
+
+#include"PrinterProfile.h"
+#include"Simulator.h"
+#include"ThreadPool.h"
+
+// One machine of the farm
+struct FarmPrinter
+{
+	std::string name;
+	// Index into FarmConfig::profiles
+	int profile = 0;
+};
+
+// One queued print, optionally pinned to a printer
+struct FarmJob
+{
+	std::string file;
+	// Index into FarmConfig::printers, -1 lets the scheduler choose
+	int printer = -1;
+};
+
+struct FarmConfig
+{
+	// Distinct profiles, printers sharing a profile file share an entry
+	std::vector<PrinterProfile> profiles;
+	std::vector<std::string> profileFiles;
+	std::vector<FarmPrinter> printers;
+	// Jobs in queue order
+	std::vector<FarmJob> jobs;
+	// Time between two jobs on the same printer, for clearing the bed
+	double changeoverTime = 0.0;
+};
+
+// Reads a farm description:
+//   printer <name> [profile.ini] [count]
+//   job <file.gcode> [count] [printer name]
+//   changeover = <seconds>
+// Relative paths are resolved against the directory of the farm file.
+bool loadFarmConfig(const char* filename, FarmConfig& config);
+
+// One job on a printer's timeline
+struct FarmTimelineEntry
+{
+	size_t job;
+	double start;
+	double end;
+};
+
+struct FarmResult
+{
+	// Jobs every printer runs, in order
+	std::vector<std::vector<FarmTimelineEntry>> timelines;
+	// Jobs whose file could not be read, they are left out of the timelines
+	std::vector<size_t> failedJobs;
+
+	// Time until the last printer is done
+	double makespan = 0.0;
+	// Sum of all simulated print times
+	double machineHours = 0.0;
+	// Real time the simulation took
+	double wallSeconds = 0.0;
+	size_t simulatedPrograms = 0;
+};
+
+// Simulates every job on the pool, then dispatches the queue to the printers
+void simulateFarm(const FarmConfig& config, ThreadPool& pool, FarmResult& result);
+// Writes the aggregate numbers and the per-printer timelines as JSON
+void writeFarmJson(std::ostream& out, const FarmConfig& config, const FarmResult& result);
+
+#endif
@@ -0,0 +1,93 @@
+#include"Flow.h"
+
+#include<algorithm>
+#include<iomanip>
+
+// Volumetric flow of every move in mm^3/s
+void computeFlow(const Toolpath& toolpath, const MotionPlan& plan, const PrinterProfile& profile, std::vector<float>& flow)
+{
+	size_t count = toolpath.size();
+	flow.resize(count);
+	if (count == 0)
+		return;
+
+	float radius = profile.filamentDiameter * 0.5f;
+	const float area = 3.14159265f * radius * radius;
+	const float* e = toolpath.e.data();
+	const float* duration = plan.duration.data();
+	float* out = flow.data();
+
+	// One pass over the columns without branches, the previous E of move i is e[i - 1]
+	out[0] = std::max(e[0] - toolpath.originE, 0.0f) * area / std::max(duration[0], 1e-9f);
+	for (size_t i = 1; i < count; i++)
+		out[i] = std::max(e[i] - e[i - 1], 0.0f) * area / std::max(duration[i], 1e-9f);
+
+	// Moves that take no time do not extrude anything the hotend has to melt in time, and primes
+	// or E advances without head movement only refill the nozzle, they do not lay down a bead
+	const unsigned char* flags = toolpath.flags.data();
+	for (size_t i = 0; i < count; i++)
+	{
+		bool moves = toolpath.position(i) != toolpath.startOf(i);
+		out[i] = duration[i] > 0.0f && moves && !(flags[i] & MOVE_RETRACTS) ? out[i] : 0.0f;
+	}
+}
+
+// Peak, average, histogram and the moves above profile.maxVolumetricFlow
+void computeFlowStats(const Toolpath& toolpath, const MotionPlan& plan, const std::vector<float>& flow,
+	const PrinterProfile& profile, FlowStats& stats)
+{
+	stats = FlowStats();
+	stats.limit = profile.maxVolumetricFlow;
+	// The histogram spans twice the melt limit so the violations have bins of their own
+	stats.histogramStep = std::max(profile.maxVolumetricFlow * 2.0f / FlowStats::histogramBins, 1e-3f);
+
+	double volume = 0.0;
+	double time = 0.0;
+	for (size_t i = 0; i < flow.size(); i++)
+	{
+		if (flow[i] <= 0.0f)
+			continue;
+		stats.extrudingMoves++;
+		stats.peakFlow = std::max(stats.peakFlow, flow[i]);
+		volume += (double)flow[i] * plan.duration[i];
+		time += plan.duration[i];
+		int bin = std::min((int)(flow[i] / stats.histogramStep), FlowStats::histogramBins - 1);
+		stats.histogram[bin]++;
+
+		if (flow[i] > profile.maxVolumetricFlow)
+		{
+			FlowViolation violation;
+			violation.move = i;
+			violation.line = toolpath.line[i];
+			violation.flow = flow[i];
+			stats.violations.push_back(violation);
+		}
+	}
+	stats.averageFlow = time > 0.0 ? volume / time : 0.0;
+}
+
+// Writes the flow statistics as one JSON object
+void writeFlowStatsJson(std::ostream& out, const FlowStats& stats)
+{
+	out << std::setprecision(9);
+	out << "{\"limit\": " << stats.limit;
+	out << ", \"peak\": " << stats.peakFlow;
+	out << ", \"average\": " << stats.averageFlow;
+	out << ", \"extruding_moves\": " << stats.extrudingMoves;
+	out << ", \"histogram_step\": " << stats.histogramStep;
+	out << ", \"histogram\": [";
+	for (int bin = 0; bin < FlowStats::histogramBins; bin++)
+		out << (bin == 0 ? "" : ", ") << stats.histogram[bin];
+	out << "]";
+
+	out << ", \"over_limit_moves\": " << stats.violations.size();
+	out << ", \"over_limit\": [";
+	// The list is capped, the count above has the full number
+	size_t listed = std::min<size_t>(stats.violations.size(), 100);
+	for (size_t i = 0; i < listed; i++)
+	{
+		const FlowViolation& violation = stats.violations[i];
+		out << (i == 0 ? "" : ", ") << "{\"line\": " << violation.line << ", \"flow\": " << violation.flow << "}";
+	}
+	out << "]}";
+}
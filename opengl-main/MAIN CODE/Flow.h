@@ -0,0 +1,46 @@
+#ifndef FLOW_CLASS_H
+#define FLOW_CLASS_H
+
+#include<ostream>
+#include<vector>
+
+#include"Gcode.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+
+// An extruding move that needs more plastic per second than the hotend can melt
+struct FlowViolation
+{
+	size_t move;
+	int line;
+	// Volumetric flow in mm^3/s
+	float flow;
+};
+
+struct FlowStats
+{
+	// Bin b counts extruding moves with flows in [b, b+1) * histogramStep, the last bin takes everything above
+	static const int histogramBins = 24;
+	float histogramStep = 1.0f;
+
+	// Melt limit the moves were checked against
+	float limit = 0.0f;
+	float peakFlow = 0.0f;
+	// Extruded volume over the time spent extruding
+	double averageFlow = 0.0;
+	size_t extrudingMoves = 0;
+	size_t histogram[histogramBins] = {};
+	std::vector<FlowViolation> violations;
+};
+
+// Volumetric flow of every move in mm^3/s: the filament its E advance pushes in over its duration.
+// Retractions, primes, travel and zero length moves get 0 and are left out of the statistics.
+void computeFlow(const Toolpath& toolpath, const MotionPlan& plan, const PrinterProfile& profile, std::vector<float>& flow);
+// Peak, average, histogram and the moves above profile.maxVolumetricFlow
+void computeFlowStats(const Toolpath& toolpath, const MotionPlan& plan, const std::vector<float>& flow,
+	const PrinterProfile& profile, FlowStats& stats);
+
+// Writes the flow statistics as one JSON object
+void writeFlowStatsJson(std::ostream& out, const FlowStats& stats);
+
+#endif
@@ -0,0 +1,31 @@
+#include"Frustum.h"
+
+// Extracts the planes of a camera matrix
+Frustum::Frustum(const glm::mat4& cameraMatrix)
+{
+	// A point is inside when -w <= x, y, z <= w in clip space, every bound is a row combination
+	glm::mat4 rows = glm::transpose(cameraMatrix);
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+// False only if the box lies completely outside one of the planes
+bool Frustum::intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+	for (const glm::vec4& plane : planes)
+	{
+		// Corner of the box furthest along the plane normal
+		glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+			plane.y >= 0.0f ? boxMax.y : boxMin.y,
+			plane.z >= 0.0f ? boxMax.z : boxMin.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
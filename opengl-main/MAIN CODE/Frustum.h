@@ -0,0 +1,19 @@
+#ifndef FRUSTUM_CLASS_H
+#define FRUSTUM_CLASS_H
+
+#include<glm/glm.hpp>
+
+// Planes of the volume a camera sees, taken from its projection * view matrix
+struct Frustum
+{
+	// Left, right, bottom, top, near, far, as (normal, distance) with the normal pointing inwards
+	glm::vec4 planes[6];
+
+	// Extracts the planes of a camera matrix
+	Frustum(const glm::mat4& cameraMatrix);
+
+	// False only if the box lies completely outside one of the planes
+	bool intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include"Gcode.h"
+
+#include<algorithm>
+#include<cctype>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+
+// Height difference below which two moves count as the same layer
+static const float layerEpsilon = 1e-4f;
+
+// Removes all moves but keeps the allocated memory
+void Toolpath::clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	e.clear();
+	feedrate.clear();
+	line.clear();
+	layer.clear();
+	flags.clear();
+	tool.clear();
+	fan.clear();
+	feature.clear();
+	layerStart.clear();
+	layerHeight.clear();
+	heaterCommands.clear();
+	toolChanges.clear();
+	toolCount = 1;
+	featureNames.clear();
+	extrudes = false;
+}
+
+void Toolpath::reserve(size_t moves)
+{
+	x.reserve(moves);
+	y.reserve(moves);
+	z.reserve(moves);
+	e.reserve(moves);
+	feedrate.reserve(moves);
+	line.reserve(moves);
+	layer.reserve(moves);
+	flags.reserve(moves);
+	tool.reserve(moves);
+	fan.reserve(moves);
+	feature.reserve(moves);
+}
+
+// Parser constructor that starts at the origin with the profile's defaults
+GcodeParser::GcodeParser(const PrinterProfile& profile)
+{
+	GcodeParser::profile = profile;
+	feedrate = profile.defaultFeedrate;
+	currentLayerHeight = 0.0f;
+}
+
+// Parses a whole program and appends its moves
+void GcodeParser::parse(const char* text, size_t length, Toolpath& toolpath)
+{
+	// Typical slicer output has a move every 20-30 bytes
+	toolpath.reserve(toolpath.size() + length / 24);
+
+	const char* end = text + length;
+	const char* lineBegin = text;
+	while (lineBegin < end)
+	{
+		const char* lineEnd = (const char*)memchr(lineBegin, '\n', end - lineBegin);
+		if (lineEnd == NULL)
+			lineEnd = end;
+		parseLine(lineBegin, lineEnd, toolpath);
+		lineBegin = lineEnd + 1;
+	}
+}
+
+void GcodeParser::parse(const std::string& text, Toolpath& toolpath)
+{
+	parse(text.c_str(), text.size(), toolpath);
+}
+
+// Parses a single line without its line terminator
+void GcodeParser::parseLine(const char* begin, const char* end, Toolpath& toolpath)
+{
+	lineNumber++;
+
+	// Words of the line, letters are stored upper case
+	char letters[32];
+	float values[32];
+	const char* numbers[32];
+	int words = 0;
+
+	// Slicers name the feature that follows, e.g. ";TYPE:WALL-OUTER" or ";TYPE:Solid infill"
+	if (end - begin > 6 && memcmp(begin, ";TYPE:", 6) == 0)
+	{
+		std::string name(begin + 6, end);
+		while (!name.empty() && isspace((unsigned char)name.back()))
+			name.pop_back();
+		auto found = std::find(toolpath.featureNames.begin(), toolpath.featureNames.end(), name);
+		if (found == toolpath.featureNames.end() && toolpath.featureNames.size() < 255)
+			found = toolpath.featureNames.insert(found, name);
+		if (found != toolpath.featureNames.end())
+			feature = (int)(found - toolpath.featureNames.begin()) + 1;
+		return;
+	}
+
+	const char* c = begin;
+	while (c < end && words < 32)
+	{
+		char letter = *c;
+		// Everything after ';' is a comment, "(...)" is an inline comment
+		if (letter == ';')
+			break;
+		if (letter == '(')
+		{
+			while (c < end && *c != ')')
+				c++;
+			c++;
+			continue;
+		}
+		if (letter >= 'a' && letter <= 'z')
+			letter -= 'a' - 'A';
+		if (letter < 'A' || letter > 'Z')
+		{
+			c++;
+			continue;
+		}
+
+		// A word is a letter directly followed by a number
+		const char* number = c + 1;
+		if (number >= end || !(isdigit((unsigned char)*number) || *number == '-' || *number == '+' || *number == '.'))
+		{
+			c++;
+			continue;
+		}
+		char* parsed;
+		float value = strtof(number, &parsed);
+		if (parsed == number || parsed > end)
+		{
+			c++;
+			continue;
+		}
+		letters[words] = letter;
+		values[words] = value;
+		numbers[words] = number;
+		words++;
+		c = parsed;
+	}
+
+	if (words == 0)
+		return;
+
+	// The first word is the command, "G01" and "G1" are the same command
+	const char* number = numbers[0];
+	const char* numberEnd = number;
+	while (numberEnd < end && (isdigit((unsigned char)*numberEnd) || *numberEnd == '.'))
+		numberEnd++;
+	while (number + 1 < numberEnd && *number == '0' && number[1] != '.')
+		number++;
+	std::string command(1, letters[0]);
+	command.append(number, numberEnd);
+	commandCounts[command]++;
+
+	if (command == "G0" || command == "G1")
+	{
+		glm::vec3 target = absolutePositioning ? position : glm::vec3(0.0f);
+		float newE = absoluteExtrusion ? e : 0.0f;
+		for (int i = 1; i < words; i++)
+		{
+			switch (letters[i])
+			{
+			case 'X': target.x = values[i]; break;
+			case 'Y': target.y = values[i]; break;
+			case 'Z': target.z = values[i]; break;
+			case 'E': newE = values[i]; break;
+			case 'F': feedrate = values[i] / 60.0f; break;
+			}
+		}
+		if (!absolutePositioning)
+			target += position;
+		if (!absoluteExtrusion)
+			newE += e;
+		addMove(command == "G0", target, newE, toolpath);
+	}
+	else if (command == "G28")
+	{
+		// Homing drives the named axes, or all of them, back to zero
+		glm::vec3 target = position;
+		bool any = false;
+		for (int i = 1; i < words; i++)
+		{
+			if (letters[i] == 'X') { target.x = 0.0f; any = true; }
+			if (letters[i] == 'Y') { target.y = 0.0f; any = true; }
+			if (letters[i] == 'Z') { target.z = 0.0f; any = true; }
+		}
+		if (!any)
+			target = glm::vec3(0.0f);
+		addMove(true, target, e, toolpath);
+	}
+	else if (command == "G90")
+	{
+		absolutePositioning = true;
+		absoluteExtrusion = true;
+	}
+	else if (command == "G91")
+	{
+		absolutePositioning = false;
+		absoluteExtrusion = false;
+	}
+	else if (command == "M82")
+	{
+		absoluteExtrusion = true;
+	}
+	else if (command == "M83")
+	{
+		absoluteExtrusion = false;
+	}
+	else if (letters[0] == 'T')
+	{
+		// Tool changes take effect with the next move
+		int newTool = (int)values[0];
+		if (newTool >= 0 && newTool < 256 && newTool != tool)
+		{
+			ToolChange change;
+			change.move = toolpath.size();
+			change.line = lineNumber;
+			change.tool = newTool;
+			toolpath.toolChanges.push_back(change);
+			toolpath.toolCount = std::max(toolpath.toolCount, newTool + 1);
+			tool = newTool;
+		}
+	}
+	else if (command == "M104" || command == "M109" || command == "M140" || command == "M190")
+	{
+		bool bed = command == "M140" || command == "M190";
+		for (int i = 1; i < words; i++)
+		{
+			if (letters[i] != 'S')
+				continue;
+			if (bed)
+				bedTemperature = values[i];
+			else
+				hotendTemperature = values[i];
+
+			HeaterCommand heaterCommand;
+			heaterCommand.move = toolpath.size();
+			heaterCommand.line = lineNumber;
+			heaterCommand.heater = bed ? HEATER_BED : HEATER_HOTEND;
+			heaterCommand.wait = command == "M109" || command == "M190";
+			heaterCommand.target = values[i];
+			toolpath.heaterCommands.push_back(heaterCommand);
+		}
+	}
+	else if (command == "M106" || command == "M107")
+	{
+		// M106 without S runs the fan at full speed
+		fanSpeed = command == "M107" ? 0 : 255;
+		for (int i = 1; i < words; i++)
+		{
+			if (letters[i] == 'S')
+				fanSpeed = (int)std::min(std::max(values[i], 0.0f), 255.0f);
+		}
+	}
+	else if (command == "G92")
+	{
+		// Redefines the current position without moving, the machine keeps its place
+		glm::vec3 machinePosition = position + positionOffset;
+		float machineE = e + eOffset;
+		for (int i = 1; i < words; i++)
+		{
+			switch (letters[i])
+			{
+			case 'X': position.x = values[i]; break;
+			case 'Y': position.y = values[i]; break;
+			case 'Z': position.z = values[i]; break;
+			case 'E': e = values[i]; break;
+			}
+		}
+		positionOffset = machinePosition - position;
+		eOffset = machineE - e;
+	}
+}
+
+// Copies the modal state out, and back in to continue from a saved point
+ParserState GcodeParser::saveState() const
+{
+	ParserState state;
+	state.position = position;
+	state.e = e;
+	state.positionOffset = positionOffset;
+	state.eOffset = eOffset;
+	state.feedrate = feedrate;
+	state.absolutePositioning = absolutePositioning;
+	state.absoluteExtrusion = absoluteExtrusion;
+	state.hotendTemperature = hotendTemperature;
+	state.bedTemperature = bedTemperature;
+	state.tool = tool;
+	state.fanSpeed = fanSpeed;
+	state.feature = feature;
+	state.lineNumber = lineNumber;
+	state.outOfBoundsMoves = outOfBoundsMoves;
+	state.currentLayerHeight = currentLayerHeight;
+	return state;
+}
+
+void GcodeParser::restoreState(const ParserState& state)
+{
+	position = state.position;
+	e = state.e;
+	positionOffset = state.positionOffset;
+	eOffset = state.eOffset;
+	feedrate = state.feedrate;
+	absolutePositioning = state.absolutePositioning;
+	absoluteExtrusion = state.absoluteExtrusion;
+	hotendTemperature = state.hotendTemperature;
+	bedTemperature = state.bedTemperature;
+	tool = state.tool;
+	fanSpeed = state.fanSpeed;
+	feature = state.feature;
+	lineNumber = state.lineNumber;
+	outOfBoundsMoves = state.outOfBoundsMoves;
+	currentLayerHeight = state.currentLayerHeight;
+}
+
+void GcodeParser::addMove(bool rapid, glm::vec3 target, float newE, Toolpath& toolpath)
+{
+	if (toolpath.size() == 0)
+	{
+		toolpath.origin = position + positionOffset;
+		toolpath.originE = e + eOffset;
+	}
+
+	unsigned char moveFlags = rapid ? MOVE_RAPID : 0;
+
+	glm::vec3 machineTarget = target + positionOffset;
+	glm::vec3 clamped = glm::clamp(machineTarget, profile.bedMin, profile.bedMax);
+	if (clamped != machineTarget)
+	{
+		moveFlags |= MOVE_OUT_OF_BOUNDS;
+		outOfBoundsMoves++;
+	}
+
+	bool extrudes = newE > e;
+	if (extrudes)
+	{
+		moveFlags |= MOVE_EXTRUDES;
+		toolpath.extrudes = true;
+	}
+
+	// Only moves that extrude while the head moves print, a layer starts with the first of them above
+	// the previous layer. Clamping can pin a move to where it started, it still counts as moving.
+	bool moves = machineTarget != position + positionOffset;
+	bool printing = extrudes && moves;
+	if (newE < e || (extrudes && !moves))
+		moveFlags |= MOVE_RETRACTS;
+	else if (printing)
+		moveFlags |= MOVE_PRINTS;
+	if (toolpath.layerStart.empty())
+	{
+		toolpath.layerStart.push_back(toolpath.size());
+		toolpath.layerHeight.push_back(clamped.y);
+		currentLayerHeight = -1e30f;
+	}
+	if (printing)
+	{
+		if (currentLayerHeight == -1e30f)
+		{
+			toolpath.layerHeight.back() = clamped.y;
+			currentLayerHeight = clamped.y;
+		}
+		else if (clamped.y > currentLayerHeight + layerEpsilon)
+		{
+			toolpath.layerStart.push_back(toolpath.size());
+			toolpath.layerHeight.push_back(clamped.y);
+			currentLayerHeight = clamped.y;
+		}
+	}
+
+	toolpath.x.push_back(clamped.x);
+	toolpath.y.push_back(clamped.y);
+	toolpath.z.push_back(clamped.z);
+	toolpath.e.push_back(newE + eOffset);
+	toolpath.feedrate.push_back(feedrate);
+	toolpath.line.push_back(lineNumber);
+	toolpath.layer.push_back((int)toolpath.layerStart.size() - 1);
+	toolpath.flags.push_back(moveFlags);
+	toolpath.tool.push_back((unsigned char)tool);
+	toolpath.fan.push_back((unsigned char)fanSpeed);
+	toolpath.feature.push_back((unsigned char)feature);
+	toolpath.toolCount = std::max(toolpath.toolCount, tool + 1);
+
+	position = clamped - positionOffset;
+	e = newE;
+}
+
+// Reads a whole file into memory, returns false if it cannot be opened
+bool readTextFile(const char* filename, std::string& contents)
+{
+	std::ifstream in(filename, std::ios::binary);
+	if (!in)
+		return false;
+	in.seekg(0, std::ios::end);
+	contents.resize((size_t)in.tellg());
+	in.seekg(0, std::ios::beg);
+	in.read(&contents[0], contents.size());
+	return true;
+}
@@ -0,0 +1,202 @@
+#ifndef GCODE_CLASS_H
+#define GCODE_CLASS_H
+
+#include<glm/glm.hpp>
+#include<map>
+#include<string>
+#include<vector>
+
+#include"PrinterProfile.h"
+
+// Flags stored for every move of a toolpath
+enum MoveFlags : unsigned char
+{
+	MOVE_RAPID = 1,         // G0 instead of G1
+	MOVE_OUT_OF_BOUNDS = 2, // Target was outside the bed and got clamped
+	MOVE_EXTRUDES = 4,      // E advanced during the move
+	MOVE_RETRACTS = 8,      // E went back, or forward without the head moving to prime after a retract
+	MOVE_PRINTS = 16        // Lays down material: extrudes while moving
+};
+
+// Kinds of moves the viewer draws apart, each kept in its own part of the toolpath buffer
+enum MoveStream
+{
+	STREAM_EXTRUDE,
+	STREAM_TRAVEL,
+	STREAM_RETRACT
+};
+const int moveStreams = 3;
+
+// Stream a move with the given MoveFlags belongs to
+inline MoveStream moveStream(unsigned char flags)
+{
+	if (flags & MOVE_RETRACTS)
+		return STREAM_RETRACT;
+	return (flags & MOVE_PRINTS) ? STREAM_EXTRUDE : STREAM_TRAVEL;
+}
+
+// Heaters a temperature command can address
+enum Heater : unsigned char
+{
+	HEATER_HOTEND,
+	HEATER_BED
+};
+
+// A temperature command (M104, M109, M140, M190) between two moves
+struct HeaterCommand
+{
+	// Index of the move that follows the command
+	size_t move;
+	int line;
+	Heater heater;
+	// M109 and M190 hold the program until the heater has heated up to its target
+	bool wait;
+	float target;
+};
+
+// A T command that switched to another tool before a move
+struct ToolChange
+{
+	// Index of the first move made with the new tool
+	size_t move;
+	int line;
+	int tool;
+};
+
+// Parsed moves stored column by column so passes over the whole job stay cache friendly
+struct Toolpath
+{
+	// Position the first move starts from
+	glm::vec3 origin = glm::vec3(0.0f, 0.0f, 0.0f);
+	// Extruder position before the first move
+	float originE = 0.0f;
+
+	// End position of every move in machine coordinates
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	// Extruder position after every move, continuous across G92 resets
+	std::vector<float> e;
+	// Requested speed in units/s
+	std::vector<float> feedrate;
+	// Source line the move came from, counted from 1
+	std::vector<int> line;
+	// Layer the move belongs to
+	std::vector<int> layer;
+	std::vector<unsigned char> flags;
+	// Tool that made the move, positions are where its nozzle goes
+	std::vector<unsigned char> tool;
+	// Part cooling fan duty set with M106/M107, 0..255
+	std::vector<unsigned char> fan;
+	// Feature the slicer marked the move as with a ";TYPE:" comment, index + 1 into featureNames, 0 for none
+	std::vector<unsigned char> feature;
+
+	// Index of the first move of every layer
+	std::vector<size_t> layerStart;
+	// Build height of every layer
+	std::vector<float> layerHeight;
+	// Temperature commands in program order
+	std::vector<HeaterCommand> heaterCommands;
+	std::vector<ToolChange> toolChanges;
+	// Highest tool number used plus one
+	int toolCount = 1;
+	// Names of the ";TYPE:" features in the order they first appeared
+	std::vector<std::string> featureNames;
+	// Set once a move extrudes
+	bool extrudes = false;
+
+	size_t size() const { return x.size(); }
+	glm::vec3 position(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+	// Position the move starts from
+	glm::vec3 startOf(size_t i) const { return i == 0 ? origin : position(i - 1); }
+	float startEOf(size_t i) const { return i == 0 ? originE : e[i - 1]; }
+	// Stream move i is drawn in. Programs without E words, like plotter or laser programs, extrude
+	// nothing, their G1 moves are drawn as extrusions so the path stands out from the G0 travels.
+	MoveStream stream(size_t i) const
+	{
+		if (!extrudes && !(flags[i] & (MOVE_RAPID | MOVE_RETRACTS)))
+			return STREAM_EXTRUDE;
+		return moveStream(flags[i]);
+	}
+
+	// Removes all moves but keeps the allocated memory
+	void clear();
+	void reserve(size_t moves);
+};
+
+// Modal state of a GcodeParser, enough to continue parsing from the middle of a program
+struct ParserState
+{
+	glm::vec3 position;
+	float e;
+	glm::vec3 positionOffset;
+	float eOffset;
+	float feedrate;
+	bool absolutePositioning;
+	bool absoluteExtrusion;
+	float hotendTemperature;
+	float bedTemperature;
+	int tool;
+	int fanSpeed;
+	int feature;
+	int lineNumber;
+	size_t outOfBoundsMoves;
+	float currentLayerHeight;
+};
+
+// Streaming G-code interpreter that appends moves to a Toolpath.
+// Keeps the modal state between calls so text can be fed in pieces.
+class GcodeParser
+{
+public:
+	PrinterProfile profile;
+
+	// Modal machine state, positions are in program coordinates
+	glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
+	float e = 0.0f;
+	// Added to program coordinates to get machine coordinates, changed by G92
+	glm::vec3 positionOffset = glm::vec3(0.0f, 0.0f, 0.0f);
+	float eOffset = 0.0f;
+	float feedrate;
+	bool absolutePositioning = true;
+	bool absoluteExtrusion = true;
+	// Target temperatures set with M104/M109 and M140/M190
+	float hotendTemperature = 0.0f;
+	float bedTemperature = 0.0f;
+	// Active tool selected with T
+	int tool = 0;
+	// Fan duty 0..255 and the current feature, see Toolpath::fan and Toolpath::feature
+	int fanSpeed = 0;
+	int feature = 0;
+
+	// Number of lines read so far
+	int lineNumber = 0;
+	// How often every command word (G1, M104, T0...) appeared
+	std::map<std::string, size_t> commandCounts;
+	// Moves whose target had to be clamped to the bed
+	size_t outOfBoundsMoves = 0;
+
+	// Parser constructor that starts at the origin with the profile's defaults
+	GcodeParser(const PrinterProfile& profile);
+
+	// Parses a whole program and appends its moves
+	void parse(const char* text, size_t length, Toolpath& toolpath);
+	void parse(const std::string& text, Toolpath& toolpath);
+	// Parses a single line without its line terminator
+	void parseLine(const char* begin, const char* end, Toolpath& toolpath);
+
+	// Copies the modal state out, and back in to continue from a saved point
+	ParserState saveState() const;
+	void restoreState(const ParserState& state);
+
+private:
+	// Height of the layer currently being printed
+	float currentLayerHeight;
+
+	void addMove(bool rapid, glm::vec3 target, float newE, Toolpath& toolpath);
+};
+
+// Reads a whole file into memory, returns false if it cannot be opened
+bool readTextFile(const char* filename, std::string& contents);
+
+#endif
@@ -0,0 +1,203 @@
+#include"JogLog.h"
+
+#include<cstdio>
+#include<cstring>
+#include<fstream>
+
+// File starts with these bytes followed by the format version
+static const char jogLogMagic[4] = { 'J', 'O', 'G', 'L' };
+static const uint32_t jogLogVersion = 1;
+
+// Moves the head by one tick of jogging with the held keys, exactly like the viewer's arrow mode
+glm::vec3 jogStep(glm::vec3 position, unsigned char keys, glm::vec3 bedMin, glm::vec3 bedMax, float step)
+{
+	// Same checks in the same order as the key handling it replaces, so replays match to the bit
+	glm::vec3 velocity = glm::vec3(0.0f, 0.0f, 0.0f);
+	if ((keys & JOG_Z_MINUS) && position.z - step >= bedMin.z)
+		velocity.z = -step;
+	if ((keys & JOG_Z_PLUS) && position.z + step <= bedMax.z)
+		velocity.z = step;
+	if ((keys & JOG_X_MINUS) && position.x - step >= bedMin.x)
+		velocity.x = -step;
+	if ((keys & JOG_X_PLUS) && position.x + step <= bedMax.x)
+		velocity.x = step;
+	if ((keys & JOG_Y_PLUS) && position.y + step <= bedMax.y)
+		velocity.y = step;
+	if ((keys & JOG_Y_MINUS) && position.y - step >= bedMin.y)
+		velocity.y = -step;
+	return position + velocity;
+}
+
+// Appends one tick
+void JogLog::addTick(unsigned char keys)
+{
+	if (!runs.empty() && runs.back().keys == keys && runs.back().ticks < UINT32_MAX)
+	{
+		runs.back().ticks++;
+		return;
+	}
+	JogRun run;
+	run.keys = keys;
+	run.ticks = 1;
+	runs.push_back(run);
+}
+
+uint64_t JogLog::tickCount() const
+{
+	uint64_t count = 0;
+	for (const JogRun& run : runs)
+		count += run.ticks;
+	return count;
+}
+
+// Run lengths are stored 7 bits per byte, most runs fit in one or two bytes
+static void writeVarint(std::ofstream& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.put((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.put((char)value);
+}
+
+static bool readVarint(std::ifstream& in, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		int byte = in.get();
+		if (byte == EOF)
+			return false;
+		value |= (uint32_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Writes the log to a compact binary file
+bool writeJogLog(const char* filename, const JogLog& log)
+{
+	std::ofstream out(filename, std::ios::binary);
+	if (!out)
+		return false;
+	uint64_t runCount = log.runs.size();
+	out.write(jogLogMagic, sizeof(jogLogMagic));
+	out.write((const char*)&jogLogVersion, sizeof(jogLogVersion));
+	out.write((const char*)&log.start, sizeof(glm::vec3));
+	out.write((const char*)&log.bedMin, sizeof(glm::vec3));
+	out.write((const char*)&log.bedMax, sizeof(glm::vec3));
+	out.write((const char*)&log.step, sizeof(float));
+	out.write((const char*)&log.ticksPerSecond, sizeof(float));
+	out.write((const char*)&runCount, sizeof(runCount));
+	for (const JogRun& run : log.runs)
+	{
+		out.put((char)run.keys);
+		writeVarint(out, run.ticks);
+	}
+	return (bool)out;
+}
+
+// Reads a log written by writeJogLog
+bool readJogLog(const char* filename, JogLog& log)
+{
+	std::ifstream in(filename, std::ios::binary);
+	if (!in)
+		return false;
+	char magic[4];
+	uint32_t version = 0;
+	uint64_t runCount = 0;
+	in.read(magic, sizeof(magic));
+	in.read((char*)&version, sizeof(version));
+	if (!in || memcmp(magic, jogLogMagic, sizeof(magic)) != 0 || version != jogLogVersion)
+		return false;
+	in.read((char*)&log.start, sizeof(glm::vec3));
+	in.read((char*)&log.bedMin, sizeof(glm::vec3));
+	in.read((char*)&log.bedMax, sizeof(glm::vec3));
+	in.read((char*)&log.step, sizeof(float));
+	in.read((char*)&log.ticksPerSecond, sizeof(float));
+	in.read((char*)&runCount, sizeof(runCount));
+	if (!in)
+		return false;
+
+	log.runs.clear();
+	for (uint64_t i = 0; i < runCount; i++)
+	{
+		JogRun run;
+		int keys = in.get();
+		if (keys == EOF || !readVarint(in, run.ticks))
+			return false;
+		run.keys = (unsigned char)keys;
+		log.runs.push_back(run);
+	}
+	return true;
+}
+
+// Replays every tick and returns the head position after each one that moved it
+void replayJogLog(const JogLog& log, std::vector<glm::vec3>& positions)
+{
+	positions.clear();
+	glm::vec3 position = log.start;
+	for (const JogRun& run : log.runs)
+	{
+		// Nothing moves while no key is held, the whole run can be skipped
+		if (run.keys == 0)
+			continue;
+		for (uint32_t tick = 0; tick < run.ticks; tick++)
+		{
+			glm::vec3 next = jogStep(position, run.keys, log.bedMin, log.bedMax, log.step);
+			if (next == position)
+				break;
+			position = next;
+			positions.push_back(position);
+		}
+	}
+}
+
+// Replays the log and writes it as G-code, one G1 per straight stretch of the path
+void writeJogGcode(std::ostream& out, const JogLog& log)
+{
+	char line[128];
+	out << "; jog session, " << log.tickCount() << " ticks at " << log.ticksPerSecond << " ticks/s\n";
+	out << "G90\n";
+	snprintf(line, sizeof(line), "G0 X%.4f Y%.4f Z%.4f\n", log.start.x, log.start.y, log.start.z);
+	out << line;
+
+	// A stretch ends when the direction of the steps changes, which also happens when an axis hits the
+	// bed edge. Rounding makes steps of the same direction differ in the last bits, so only signs count.
+	glm::vec3 position = log.start;
+	glm::vec3 stretchStart = position;
+	glm::vec3 stretchDirection = glm::vec3(0.0f);
+	uint64_t stretchTicks = 0;
+	auto flush = [&]()
+	{
+		if (stretchTicks == 0)
+			return;
+		float feedrate = glm::length(position - stretchStart) / stretchTicks * log.ticksPerSecond * 60.0f;
+		snprintf(line, sizeof(line), "G1 X%.4f Y%.4f Z%.4f F%.1f\n", position.x, position.y, position.z, feedrate);
+		out << line;
+		stretchStart = position;
+		stretchTicks = 0;
+	};
+	for (const JogRun& run : log.runs)
+	{
+		if (run.keys == 0)
+			continue;
+		for (uint32_t tick = 0; tick < run.ticks; tick++)
+		{
+			glm::vec3 next = jogStep(position, run.keys, log.bedMin, log.bedMax, log.step);
+			glm::vec3 direction = glm::sign(next - position);
+			if (direction == glm::vec3(0.0f))
+				break;
+			if (direction != stretchDirection)
+			{
+				flush();
+				stretchDirection = direction;
+			}
+			position = next;
+			stretchTicks++;
+		}
+	}
+	flush();
+}
@@ -0,0 +1,58 @@
+#ifndef JOG_LOG_CLASS_H
+#define JOG_LOG_CLASS_H
+
+#include<glm/glm.hpp>
+#include<cstdint>
+#include<ostream>
+#include<vector>
+
+// Jog keys held during a tick, one bit each
+enum JogKey : unsigned char
+{
+	JOG_Z_MINUS = 1,  // Arrow up
+	JOG_Z_PLUS = 2,   // Arrow down
+	JOG_X_MINUS = 4,  // Arrow left
+	JOG_X_PLUS = 8,   // Arrow right
+	JOG_Y_PLUS = 16,  // Page up
+	JOG_Y_MINUS = 32  // Page down
+};
+
+// Moves the head by one tick of jogging with the held keys, exactly like the viewer's arrow mode.
+// Axes that would leave the bed stay where they are.
+glm::vec3 jogStep(glm::vec3 position, unsigned char keys, glm::vec3 bedMin, glm::vec3 bedMax, float step);
+
+// A stretch of ticks with the same keys held
+struct JogRun
+{
+	unsigned char keys;
+	uint32_t ticks;
+};
+
+// Jog session stored as run-length encoded key states, one tick per frame of the viewer
+struct JogLog
+{
+	glm::vec3 start = glm::vec3(0.0f);
+	glm::vec3 bedMin = glm::vec3(0.0f);
+	glm::vec3 bedMax = glm::vec3(0.0f);
+	// Distance every axis moves per tick
+	float step = 0.01f;
+	// Ticks per second while recording, only used to give exported G-code real feedrates
+	float ticksPerSecond = 60.0f;
+	std::vector<JogRun> runs;
+
+	// Appends one tick
+	void addTick(unsigned char keys);
+	uint64_t tickCount() const;
+};
+
+// Writes the log to a compact binary file, returns false if it cannot be written
+bool writeJogLog(const char* filename, const JogLog& log);
+// Reads a log written by writeJogLog, returns false if the file is missing or not a jog log
+bool readJogLog(const char* filename, JogLog& log);
+
+// Replays every tick and returns the head position after each one that moved it
+void replayJogLog(const JogLog& log, std::vector<glm::vec3>& positions);
+// Replays the log and writes it as G-code, one G1 per straight stretch of the path
+void writeJogGcode(std::ostream& out, const JogLog& log);
+
+#endif
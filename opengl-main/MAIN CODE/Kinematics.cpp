@@ -0,0 +1,205 @@
+#include"Kinematics.h"
+
+#include<algorithm>
+#include<cmath>
+
+// Head positions are converted in blocks of this many pieces
+static const size_t blockSize = 1024;
+
+// Name of a motor lane for reports
+const char* motorName(KinematicsType kinematics, int lane)
+{
+	static const char* cartesian[4] = { "x", "y", "z", "e" };
+	static const char* corexy[4] = { "a", "y", "b", "e" };
+	static const char* delta[4] = { "tower_a", "tower_b", "tower_c", "e" };
+	if (kinematics == KINEMATICS_COREXY)
+		return corexy[lane];
+	if (kinematics == KINEMATICS_DELTA)
+		return delta[lane];
+	return cartesian[lane];
+}
+
+// Head positions to motor positions for count points stored column by column
+void inverseKinematics(const PrinterProfile& profile, const float* x, const float* y, const float* z, size_t count,
+	float* motor0, float* motor1, float* motor2)
+{
+	if (profile.kinematics == KINEMATICS_COREXY)
+	{
+		// Both belts drive the bed plane, Y keeps its own motor
+		for (size_t i = 0; i < count; i++)
+		{
+			motor0[i] = x[i] + z[i];
+			motor1[i] = y[i];
+			motor2[i] = x[i] - z[i];
+		}
+	}
+	else if (profile.kinematics == KINEMATICS_DELTA)
+	{
+		// Towers stand at 210, 330 and 90 degrees around the bed center, every carriage sits
+		// one rod length away from the head. Unreachable points are clamped to the tower base.
+		const float rod2 = profile.deltaDiagonalRod * profile.deltaDiagonalRod;
+		float* motors[3] = { motor0, motor1, motor2 };
+		for (int tower = 0; tower < 3; tower++)
+		{
+			float angle = glm::radians(210.0f + 120.0f * tower);
+			float towerX = profile.deltaRadius * std::cos(angle);
+			float towerZ = profile.deltaRadius * std::sin(angle);
+			float* motor = motors[tower];
+			for (size_t i = 0; i < count; i++)
+			{
+				float dx = x[i] - towerX;
+				float dz = z[i] - towerZ;
+				motor[i] = y[i] + std::sqrt(std::max(rod2 - dx * dx - dz * dz, 0.0f));
+			}
+		}
+	}
+	else
+	{
+		std::copy(x, x + count, motor0);
+		std::copy(y, y + count, motor1);
+		std::copy(z, z + count, motor2);
+	}
+}
+
+// Collects piece end points of the head and turns them into motor travel a block at a time
+struct PieceBlock
+{
+	float x[blockSize], y[blockSize], z[blockSize];
+	float motor0[blockSize], motor1[blockSize], motor2[blockSize];
+	float e[blockSize];
+	// Move every piece belongs to, its head travel and whether it ends the move
+	size_t move[blockSize];
+	float length[blockSize];
+	bool last[blockSize];
+	size_t count = 0;
+};
+
+// Converts the collected pieces and folds their motor travel into the moves
+static void flushPieces(const PrinterProfile& profile, PieceBlock& block, glm::vec4& previous, MotorPath& motors)
+{
+	inverseKinematics(profile, block.x, block.y, block.z, block.count, block.motor0, block.motor1, block.motor2);
+	for (size_t k = 0; k < block.count; k++)
+	{
+		glm::vec4 current(block.motor0[k], block.motor1[k], block.motor2[k], block.e[k]);
+		size_t move = block.move[k];
+		if (block.length[k] > 0.0f)
+			motors.gain[move] = glm::max(motors.gain[move], glm::abs(current - previous) / block.length[k]);
+		if (block.last[k])
+			motors.end[move] = current;
+		previous = current;
+	}
+	block.count = 0;
+}
+
+// Motor positions and gains of every move, delta moves are split per deltaSegmentsPerSecond
+void buildMotorPath(const Toolpath& toolpath, const PrinterProfile& profile, MotorPath& motors)
+{
+	size_t count = toolpath.size();
+	motors.end.assign(count, glm::vec4(0.0f));
+	motors.gain.assign(count, glm::vec4(0.0f));
+	motors.peakVelocity.assign(count, glm::vec4(0.0f));
+	motors.pieces = 0;
+
+	// Toolpath positions are nozzle positions, the motors move the carriage the active tool is offset from
+	int previousTool = count > 0 ? toolpath.tool[0] : 0;
+	glm::vec3 originCarriage = toolpath.origin - profile.toolOffset(previousTool);
+	float originMotor[3];
+	inverseKinematics(profile, &originCarriage.x, &originCarriage.y, &originCarriage.z, 1,
+		&originMotor[0], &originMotor[1], &originMotor[2]);
+	motors.origin = glm::vec4(originMotor[0], originMotor[1], originMotor[2], toolpath.originE);
+
+	// Large enough for a few thousand moves, kept off the stack
+	std::vector<PieceBlock> storage(1);
+	PieceBlock& block = storage[0];
+	glm::vec4 previous = motors.origin;
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 start = toolpath.startOf(i);
+		glm::vec3 end = toolpath.position(i);
+		float startE = toolpath.startEOf(i);
+		float travel = glm::length(end - start);
+		// Extruder only moves are measured along E like the planner does
+		float length = travel > 0.0f ? travel : std::abs(toolpath.e[i] - startE);
+
+		// Linear kinematics keep straight lines straight, delta moves are cut up like the firmware does
+		size_t pieces = 1;
+		if (profile.kinematics == KINEMATICS_DELTA && travel > 0.0f && toolpath.feedrate[i] > 0.0f)
+		{
+			float seconds = travel / toolpath.feedrate[i];
+			pieces = std::max<size_t>(1, (size_t)std::ceil(seconds * profile.deltaSegmentsPerSecond));
+		}
+		motors.pieces += pieces;
+
+		// After a tool change the carriage first shifts by the offset difference while the machine
+		// dwells, the shift is added as a piece of no head travel so it does not count towards the gain
+		int tool = toolpath.tool[i];
+		glm::vec3 offset = profile.toolOffset(tool);
+		size_t first = tool != previousTool ? 0 : 1;
+		previousTool = tool;
+
+		for (size_t p = first; p <= pieces; p++)
+		{
+			float t = (float)p / pieces;
+			glm::vec3 point = (p == pieces ? end : glm::mix(start, end, t)) - offset;
+			size_t k = block.count++;
+			block.x[k] = point.x;
+			block.y[k] = point.y;
+			block.z[k] = point.z;
+			block.e[k] = p == pieces ? toolpath.e[i] : startE + (toolpath.e[i] - startE) * t;
+			block.move[k] = i;
+			block.length[k] = p == 0 ? 0.0f : length / pieces;
+			block.last[k] = p == pieces;
+			if (block.count == blockSize)
+				flushPieces(profile, block, previous, motors);
+		}
+	}
+	flushPieces(profile, block, previous, motors);
+}
+
+// Caps the speed of every move so no motor exceeds maxMotorVelocity and lists the moves that asked for more
+void motorSpeedLimits(const Toolpath& toolpath, const MotorPath& motors, const PrinterProfile& profile,
+	std::vector<float>& speedLimit, std::vector<MotorSpeedViolation>& violations)
+{
+	size_t count = toolpath.size();
+	speedLimit.assign(count, 0.0f);
+	violations.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		// The motor that has to turn fastest per unit of head travel limits the move
+		float limit = 1e30f;
+		int limiting = -1;
+		const glm::vec4& gain = motors.gain[i];
+		for (int motor = 0; motor < 4; motor++)
+		{
+			if (gain[motor] <= 0.0f)
+				continue;
+			float speed = profile.maxMotorVelocity[motor] / gain[motor];
+			if (speed < limit)
+			{
+				limit = speed;
+				limiting = motor;
+			}
+		}
+		speedLimit[i] = limit;
+
+		if (limiting >= 0 && toolpath.feedrate[i] > limit)
+		{
+			MotorSpeedViolation violation;
+			violation.move = i;
+			violation.line = toolpath.line[i];
+			violation.motor = limiting;
+			violation.velocity = toolpath.feedrate[i] * gain[limiting];
+			violation.limit = profile.maxMotorVelocity[limiting];
+			violations.push_back(violation);
+		}
+	}
+}
+
+// Fills the motor velocities once the moves are planned
+void timeMotorPath(const MotionPlan& plan, MotorPath& motors)
+{
+	size_t count = motors.size();
+	motors.peakVelocity.resize(count);
+	for (size_t i = 0; i < count; i++)
+		motors.peakVelocity[i] = motors.gain[i] * plan.cruiseSpeed[i];
+}
@@ -0,0 +1,56 @@
+#ifndef KINEMATICS_CLASS_H
+#define KINEMATICS_CLASS_H
+
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"Gcode.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+
+// Motor space version of a toolpath, one entry per move.
+// Lanes 0-2 are the motors of the kinematics, lane 3 is the extruder.
+struct MotorPath
+{
+	// Motor positions before the first move
+	glm::vec4 origin = glm::vec4(0.0f);
+	// Motor positions after every move
+	std::vector<glm::vec4> end;
+	// Highest motor travel per unit of head travel anywhere inside the move
+	std::vector<glm::vec4> gain;
+	// Fastest every motor turns during the move, filled in by timeMotorPath
+	std::vector<glm::vec4> peakVelocity;
+	// Straight pieces the firmware splits the job into, equal to the move count for linear kinematics
+	size_t pieces = 0;
+
+	size_t size() const { return end.size(); }
+};
+
+// A move whose requested feedrate would turn a motor faster than the profile allows
+struct MotorSpeedViolation
+{
+	size_t move;
+	int line;
+	int motor;
+	// Motor speed the requested feedrate asks for, and the limit
+	float velocity;
+	float limit;
+};
+
+// Name of a motor lane for reports
+const char* motorName(KinematicsType kinematics, int lane);
+
+// Head positions to motor positions for count points stored column by column.
+// The loops carry no dependencies between points so the compiler can vectorize them.
+void inverseKinematics(const PrinterProfile& profile, const float* x, const float* y, const float* z, size_t count,
+	float* motor0, float* motor1, float* motor2);
+
+// Motor positions and gains of every move, delta moves are split per deltaSegmentsPerSecond
+void buildMotorPath(const Toolpath& toolpath, const PrinterProfile& profile, MotorPath& motors);
+// Caps the speed of every move so no motor exceeds maxMotorVelocity and lists the moves that asked for more
+void motorSpeedLimits(const Toolpath& toolpath, const MotorPath& motors, const PrinterProfile& profile,
+	std::vector<float>& speedLimit, std::vector<MotorSpeedViolation>& violations);
+// Fills the motor velocities once the moves are planned
+void timeMotorPath(const MotionPlan& plan, MotorPath& motors);
+
+#endif
@@ -0,0 +1,144 @@
+#include"Limits.h"
+
+#include<algorithm>
+#include<cmath>
+#include<iomanip>
+
+// Moves every task of the parallel pass checks
+static const size_t chunkSize = 16384;
+
+// Requested velocity of a move split into (X, Y, Z, E), extruder only moves run along E
+static glm::vec4 requestedVelocity(const Toolpath& toolpath, size_t i, float& length)
+{
+	glm::vec3 delta = toolpath.position(i) - toolpath.startOf(i);
+	float deltaE = toolpath.e[i] - toolpath.startEOf(i);
+	length = glm::length(delta);
+	if (length < 1e-6f)
+		length = std::fabs(deltaE);
+	if (length < 1e-6f)
+	{
+		length = 0.0f;
+		return glm::vec4(0.0f);
+	}
+	return glm::vec4(delta, deltaE) / length * toolpath.feedrate[i];
+}
+
+// Checks the moves in [begin, end) and appends their violations
+static void checkRange(const Toolpath& toolpath, const PrinterProfile& profile, size_t begin, size_t end,
+	std::vector<LimitViolation>& violations)
+{
+	// The corner into the first move of the range needs the move before it
+	glm::vec4 previous(0.0f);
+	for (size_t i = begin; i-- > 0;)
+	{
+		float length;
+		previous = requestedVelocity(toolpath, i, length);
+		if (length > 0.0f)
+			break;
+	}
+
+	for (size_t i = begin; i < end; i++)
+	{
+		float length;
+		glm::vec4 velocity = requestedVelocity(toolpath, i, length);
+		if (length == 0.0f)
+			continue;
+
+		glm::vec4 speed = glm::abs(velocity);
+		glm::vec4 change = glm::abs(velocity - previous);
+		// Axis travel of the move, and the acceleration it takes to go from the previous axis speed to this one over it
+		glm::vec4 travel = speed / toolpath.feedrate[i] * length;
+		glm::vec4 previousSpeed = glm::abs(previous);
+		for (int axis = 0; axis < 4; axis++)
+		{
+			LimitViolation violation;
+			violation.move = (unsigned)i;
+			violation.line = toolpath.line[i];
+			violation.axis = (unsigned char)axis;
+
+			if (speed[axis] > profile.maxVelocity[axis])
+			{
+				violation.kind = LIMIT_VELOCITY;
+				violation.requested = speed[axis];
+				violation.limit = profile.maxVelocity[axis];
+				violations.push_back(violation);
+			}
+			if (travel[axis] > 1e-6f)
+			{
+				float acceleration = std::fabs(speed[axis] * speed[axis] - previousSpeed[axis] * previousSpeed[axis]) / (2.0f * travel[axis]);
+				if (acceleration > profile.maxAcceleration[axis])
+				{
+					violation.kind = LIMIT_ACCELERATION;
+					violation.requested = acceleration;
+					violation.limit = profile.maxAcceleration[axis];
+					violations.push_back(violation);
+				}
+			}
+			if (change[axis] > profile.maxJerk[axis])
+			{
+				violation.kind = LIMIT_JERK;
+				violation.requested = change[axis];
+				violation.limit = profile.maxJerk[axis];
+				violations.push_back(violation);
+			}
+		}
+		previous = velocity;
+	}
+}
+
+// Checks the requested feedrate of every move against the per-axis limits of the profile
+void checkLimits(const Toolpath& toolpath, const PrinterProfile& profile, LimitReport& report, ThreadPool* pool)
+{
+	report = LimitReport();
+	size_t count = toolpath.size();
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	std::vector<std::vector<LimitViolation>> found(chunks);
+	auto body = [&](size_t begin, size_t end)
+	{
+		checkRange(toolpath, profile, begin, end, found[begin / chunkSize]);
+	};
+	if (pool != NULL)
+		pool->parallelFor(count, chunkSize, body);
+	else if (count > 0)
+		body(0, count);
+
+	// Chunks are joined in order so the list reads like the program
+	size_t total = 0;
+	for (const std::vector<LimitViolation>& chunk : found)
+		total += chunk.size();
+	report.violations.reserve(total);
+	for (const std::vector<LimitViolation>& chunk : found)
+	{
+		report.violations.insert(report.violations.end(), chunk.begin(), chunk.end());
+		for (const LimitViolation& violation : chunk)
+			report.counts[violation.kind][violation.axis]++;
+	}
+}
+
+// Writes the counts and the first violations as one JSON object
+void writeLimitReportJson(std::ostream& out, const LimitReport& report)
+{
+	static const char* kinds[3] = { "velocity", "acceleration", "jerk" };
+	static const char* axes[4] = { "x", "y", "z", "e" };
+	out << std::setprecision(9);
+	out << "{\"violations\": " << report.violations.size();
+	for (int kind = 0; kind < 3; kind++)
+	{
+		out << ", \"" << kinds[kind] << "\": {";
+		for (int axis = 0; axis < 4; axis++)
+			out << (axis == 0 ? "" : ", ") << "\"" << axes[axis] << "\": " << report.counts[kind][axis];
+		out << "}";
+	}
+
+	out << ", \"list\": [";
+	// The list is capped, the counts above have the full numbers
+	size_t listed = std::min<size_t>(report.violations.size(), 100);
+	for (size_t i = 0; i < listed; i++)
+	{
+		const LimitViolation& violation = report.violations[i];
+		out << (i == 0 ? "" : ", ") << "{\"line\": " << violation.line;
+		out << ", \"axis\": \"" << axes[violation.axis] << "\", \"limit_kind\": \"" << kinds[violation.kind] << "\"";
+		out << ", \"requested\": " << violation.requested << ", \"limit\": " << violation.limit << "}";
+	}
+	out << "]}";
+}
@@ -0,0 +1,46 @@
+#ifndef LIMITS_CLASS_H
+#define LIMITS_CLASS_H
+
+#include<ostream>
+#include<vector>
+
+#include"Gcode.h"
+#include"PrinterProfile.h"
+#include"ThreadPool.h"
+
+// Which per-axis limit a move asks too much of
+enum LimitKind : unsigned char
+{
+	LIMIT_VELOCITY,     // The requested feedrate moves the axis faster than maxVelocity
+	LIMIT_ACCELERATION, // The move is too short for the axis to reach the requested feedrate within maxAcceleration
+	LIMIT_JERK          // The corner into the move changes the axis speed by more than maxJerk
+};
+
+// One axis of one move over one limit, kept small since bad profiles flag most moves
+struct LimitViolation
+{
+	unsigned move;
+	int line;
+	unsigned char axis;
+	LimitKind kind;
+	// What the program asks for and what the profile allows
+	float requested;
+	float limit;
+};
+
+struct LimitReport
+{
+	// Violations in move order
+	std::vector<LimitViolation> violations;
+	// Violations per kind and per axis (X, Y, Z, E)
+	size_t counts[3][4] = {};
+};
+
+// Checks the requested feedrate of every move against the per-axis limits of the profile.
+// The moves are split across the pool when one is given.
+void checkLimits(const Toolpath& toolpath, const PrinterProfile& profile, LimitReport& report, ThreadPool* pool = NULL);
+
+// Writes the counts and the first violations as one JSON object
+void writeLimitReportJson(std::ostream& out, const LimitReport& report);
+
+#endif
@@ -1,28 +1,38 @@
 #include <filesystem>
-#include <queue>
 #include <sstream>
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 #include "Mesh.h"
 #include "shaderClass.h"
 #include "VAO.h"
 #include "VBO.h"
 #include "EBO.h"
+#include "BedGrid.h"
 #include "Camera.h"
+#include "ColorLut.h"
+#include "Frustum.h"
+#include "Gcode.h"
+#include "JogLog.h"
+#include "Simulator.h"
+#include "ThreadPool.h"
+#include "ToolpathBuffer.h"
+#include "ToolpathBvh.h"
+#include "TraceBuffer.h"
+#include "TraceSpill.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
 namespace fs = std::filesystem;
 
-//G-code positions
-std::queue<glm::vec3> gcodeTargets;
-glm::vec3 targetPos = glm::vec3(0.0f, 0.0f, 0.0f);
-std::vector<glm::vec3> pastPositions;
-
 const unsigned int width = 1200;
 const unsigned int height = 800;
+// Vertical field of view of the camera in degrees
+const float fieldOfView = 45.0f;
+// A click picks moves that pass this close to the cursor
+const float pickPixels = 4.0f;
 
 Vertex vertices[] =
 {
@@ -63,115 +73,362 @@ GLuint lightIndices[] =
     4, 6, 7
 };
 
-void drawCoordinateLines(Shader& shader, Camera& camera, float scale)
+// Color of every tool's cube and trace, tool 0 keeps the original red
+const glm::vec4 toolColors[] =
 {
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+    glm::vec4(0.1f, 0.8f, 0.2f, 1.0f),
+    glm::vec4(0.2f, 0.5f, 1.0f, 1.0f),
+    glm::vec4(1.0f, 0.85f, 0.1f, 1.0f),
+    glm::vec4(0.9f, 0.2f, 0.9f, 1.0f),
+    glm::vec4(0.1f, 0.9f, 0.9f, 1.0f),
+    glm::vec4(1.0f, 0.5f, 0.1f, 1.0f),
+    glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)
+};
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+glm::vec4 toolColor(int tool)
+{
+    return toolColors[tool % (sizeof(toolColors) / sizeof(toolColors[0]))];
+}
 
-    std::vector<glm::vec3> lines;
-    for (float i = -scale; i <= scale; i += 1.0f)
-    {
-        // X lines
-        lines.push_back(glm::vec3(i, 0.0f, -scale));
-        lines.push_back(glm::vec3(i, 0.0f, scale));
+// Tools the shaders tell apart, the tool bits of ToolpathAttribute
+const int shaderTools = 16;
 
-        // Y lines
-        lines.push_back(glm::vec3(-scale, 0.0f, i));
-        lines.push_back(glm::vec3(scale, 0.0f, i));
+// Fills the toolColors uniform of the trace and tube shaders, the shader has to be active
+void setToolColors(Shader& shader)
+{
+    glm::vec4 colors[shaderTools];
+    for (int tool = 0; tool < shaderTools; tool++) {
+        colors[tool] = toolColor(tool);
     }
+    glUniform4fv(glGetUniformLocation(shader.ID, "toolColors"), shaderTools, glm::value_ptr(colors[0]));
+}
 
-    glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(glm::vec3), &lines[0], GL_STATIC_DRAW);
+// What the toolpath is colored by, the order matches colorMode in toolpath.glsl
+enum ColorMode
+{
+    COLOR_STREAM = -1, // The fixed color of a travel or retract stream
+    COLOR_TOOL,
+    COLOR_SPEED,
+    COLOR_FLOW,
+    COLOR_LAYER,
+    COLOR_FEATURE,
+    COLOR_FAN
+};
+const char* colorModeNames[] = { "Tool", "Speed", "Flow", "Layer", "Feature", "Fan" };
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// Colors of the travel and retract streams, extrusions take the chosen color mode
+const glm::vec4 streamColors[moveStreams] =
+{
+    glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+    glm::vec4(0.35f, 0.45f, 0.6f, 1.0f),
+    glm::vec4(1.0f, 0.2f, 1.0f, 1.0f)
+};
+const char* streamNames[moveStreams] = { "Show Extrusions", "Show Travels", "Show Retracts" };
 
-    shader.Activate();
-    camera.Matrix(shader, "camMatrix");
+// Slow to fast, low to high for the continuous color modes
+const std::vector<glm::vec4> gradientStops =
+{
+    glm::vec4(0.2f, 0.1f, 0.6f, 1.0f),
+    glm::vec4(0.1f, 0.5f, 1.0f, 1.0f),
+    glm::vec4(0.1f, 0.9f, 0.4f, 1.0f),
+    glm::vec4(1.0f, 0.85f, 0.1f, 1.0f),
+    glm::vec4(0.9f, 0.1f, 0.1f, 1.0f)
+};
 
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+// Section planes the trace, toolpath, tube and mesh shaders cut with, see section.glsl
+const int sectionPlaneCount = 3;
 
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINES, 0, lines.size());
+// A plane set with angles, the side the normal points to stays
+struct SectionPlane
+{
+    bool enabled = false;
+    // Direction of the normal around Y and above the bed in degrees
+    float azimuth = 0.0f;
+    float elevation = 0.0f;
+    float offset = 0.0f;
+
+    // Plane as (normal, distance) for the shaders
+    glm::vec4 equation() const
+    {
+        float a = glm::radians(azimuth);
+        float e = glm::radians(elevation);
+        glm::vec3 normal(std::cos(e) * std::cos(a), std::sin(e), std::cos(e) * std::sin(a));
+        return glm::vec4(normal, -offset);
+    }
+};
 
-    glBindVertexArray(0);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+// Hands the section planes to a shader, only the clip distances switched on with glEnable cut
+void setSectionPlanes(Shader& shader, const SectionPlane* planes)
+{
+    glm::vec4 equations[sectionPlaneCount];
+    for (int i = 0; i < sectionPlaneCount; i++) {
+        equations[i] = planes[i].equation();
+    }
+    shader.Activate();
+    glUniform4fv(glGetUniformLocation(shader.ID, "sectionPlanes"), sectionPlaneCount, glm::value_ptr(equations[0]));
 }
 
-void drawTrace(Shader& shader, Camera& camera, const std::vector<glm::vec3>& positions)
-{
-    if (positions.size() < 2)
-        return;
+// Distance a trace point may be off the straight segment it is merged into, far below a pixel
+const float traceTolerance = 0.0005f;
 
-    //VAO, VBO for lines
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+// Trace one tool left behind, split into strips wherever the tool was parked.
+// Points along a straight line are merged as they arrive, a strip only keeps the corners and the head.
+struct ToolTrace
+{
+    std::vector<glm::vec3> positions;
+    // First vertex and vertex count of every strip
+    std::vector<GLint> stripFirst;
+    std::vector<GLsizei> stripCount;
+    // Direction of the last segment of the last strip, new points in line with it move its end
+    glm::vec3 direction = glm::vec3(0.0f);
+    // Positions already written to the tool's trace buffer
+    size_t uploaded = 0;
+};
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+// Adds a point to the trace of a tool, startStrip begins a new strip instead of connecting to the last point
+void addTracePoint(std::vector<ToolTrace>& traces, int tool, glm::vec3 position, bool startStrip)
+{
+    if ((int)traces.size() <= tool) {
+        traces.resize(tool + 1);
+    }
+    ToolTrace& trace = traces[tool];
+    if (startStrip || trace.stripFirst.empty()) {
+        trace.stripFirst.push_back((GLint)trace.positions.size());
+        trace.stripCount.push_back(0);
+    }
+    else if (position == trace.positions.back()) {
+        return;
+    }
+    else if (trace.stripCount.back() >= 2) {
+        // Still on the line of the last segment and moving forward: the head moves, no new vertex
+        glm::vec3 anchor = trace.positions[trace.positions.size() - 2];
+        glm::vec3 offset = position - anchor;
+        float along = glm::dot(offset, trace.direction);
+        float head = glm::dot(trace.positions.back() - anchor, trace.direction);
+        if (along >= head && glm::length(offset - along * trace.direction) <= traceTolerance) {
+            trace.positions.back() = position;
+            trace.uploaded = std::min(trace.uploaded, trace.positions.size() - 1);
+            return;
+        }
+    }
+    trace.positions.push_back(position);
+    trace.stripCount.back()++;
+    if (trace.stripCount.back() >= 2) {
+        trace.direction = glm::normalize(position - trace.positions[trace.positions.size() - 2]);
+    }
+}
 
-    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+// Moves the oldest vertices of the largest traces to the spill file until all traces fit in budget vertices.
+// Returns false if the file cannot be written, the vertices that did not make it stay in memory.
+bool enforceTraceBudget(std::vector<ToolTrace>& traces, TraceSpill& spill, size_t budget)
+{
+    size_t total = 0;
+    for (const ToolTrace& trace : traces) {
+        total += trace.positions.size();
+    }
+    std::vector<uint32_t> counts;
+    while (total > budget) {
+        int tool = 0;
+        for (int i = 1; i < (int)traces.size(); i++) {
+            if (traces[i].positions.size() > traces[tool].positions.size()) {
+                tool = i;
+            }
+        }
+        ToolTrace& trace = traces[tool];
+        // The last segment stays, new points are merged into it
+        if (trace.positions.size() < 4)
+            break;
+        size_t count = std::min(trace.positions.size() - 2, std::max<size_t>(budget / 4, 2));
+
+        // A strip cut by the chunk keeps its cut vertex on both sides so the line stays connected
+        counts.clear();
+        size_t strip = 0;
+        while (strip < trace.stripFirst.size() && (size_t)trace.stripFirst[strip] < count) {
+            counts.push_back((uint32_t)(std::min<size_t>(trace.stripFirst[strip] + trace.stripCount[strip], count) - trace.stripFirst[strip]));
+            strip++;
+        }
+        bool cut = (size_t)(trace.stripFirst[strip - 1] + trace.stripCount[strip - 1]) > count;
+        if (!spill.spill(tool, &trace.positions[0], counts.data(), counts.size()))
+            return false;
+
+        size_t erased = cut ? count - 1 : count;
+        size_t firstKept = cut ? strip - 1 : strip;
+        trace.positions.erase(trace.positions.begin(), trace.positions.begin() + erased);
+        trace.stripFirst.erase(trace.stripFirst.begin(), trace.stripFirst.begin() + firstKept);
+        trace.stripCount.erase(trace.stripCount.begin(), trace.stripCount.begin() + firstKept);
+        if (cut) {
+            trace.stripCount[0] -= (GLsizei)(erased - trace.stripFirst[0]);
+            trace.stripFirst[0] = (GLint)erased;
+        }
+        for (GLint& first : trace.stripFirst) {
+            first -= (GLint)erased;
+        }
+        // Every kept vertex moved, the buffer is written again from the start
+        trace.uploaded = 0;
+        total -= erased;
+    }
+    return true;
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// Reads the spilled chunks that reach into the heights minY..maxY back into traces, at most budget vertices
+void loadTraceHistory(const TraceSpill& spill, float minY, float maxY, size_t budget, std::vector<ToolTrace>& traces)
+{
+    traces.clear();
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> counts;
+    size_t loaded = 0;
+    for (size_t i = 0; i < spill.chunks.size() && loaded < budget; i++) {
+        const SpilledChunk& chunk = spill.chunks[i];
+        if (chunk.boundsMax.y < minY || chunk.boundsMin.y > maxY)
+            continue;
+        if (!spill.load(i, vertices, counts))
+            continue;
+        if ((int)traces.size() <= chunk.tool) {
+            traces.resize(chunk.tool + 1);
+        }
+        ToolTrace& trace = traces[chunk.tool];
+        GLint base = (GLint)trace.positions.size();
+        for (uint32_t count : counts) {
+            trace.stripFirst.push_back(base);
+            trace.stripCount.push_back((GLsizei)count);
+            base += (GLint)count;
+        }
+        trace.positions.insert(trace.positions.end(), vertices.begin(), vertices.end());
+        loaded += chunk.vertices;
+    }
+}
 
+// Draws the traces of all tools, buffers keep one persistent trace buffer per tool
+// and only the positions added since the last frame are uploaded
+void drawTrace(Shader& shader, Camera& camera, std::vector<ToolTrace>& traces, std::vector<TraceBuffer>& buffers)
+{
     shader.Activate();
     camera.Matrix(shader, "camMatrix");
 
     glm::mat4 model = glm::mat4(1.0f);
     glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    // The live trace has no times, all of it is shown
+    glUniform1f(glGetUniformLocation(shader.ID, "currentTime"), FLT_MAX);
+    setToolColors(shader);
+
+    // One call per tool draws all of its strips
+    for (size_t tool = 0; tool < traces.size(); tool++) {
+        ToolTrace& trace = traces[tool];
+        if (trace.stripFirst.empty())
+            continue;
+        if (buffers.size() <= tool) {
+            buffers.resize(tool + 1);
+        }
+        TraceBuffer& buffer = buffers[tool];
+        if (trace.uploaded < trace.positions.size()) {
+            buffer.Write((GLintptr)trace.uploaded, &trace.positions[trace.uploaded], (GLsizeiptr)(trace.positions.size() - trace.uploaded));
+            trace.uploaded = trace.positions.size();
+        }
 
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_LINE_STRIP, 0, positions.size());
-
+        // The trace buffer has no attributes beyond the position, the tool goes in the constant value
+        glVertexAttribI4ui(1, (GLuint)tool % shaderTools, 0, 0, 0);
+        buffer.Bind();
+        glMultiDrawArrays(GL_LINE_STRIP, &trace.stripFirst[0], &trace.stripCount[0], (GLsizei)trace.stripFirst.size());
+    }
     glBindVertexArray(0);
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
 }
 
-void executeGcode(const char* gcode, std::queue<glm::vec3>& targets, float minX, float maxX, float minY, float maxY, float minZ, float maxZ)
+// Sets the uniforms the toolpath and tube shaders share for drawing the toolpath buffer
+void setToolpathUniforms(Shader& shader, Camera& camera, ToolpathBuffer& buffer, float currentTime, ColorMode colorMode,
+    ColorLut& lut, const glm::vec4& streamColor)
 {
-    std::istringstream stream(gcode);
-    std::string line;
-
-    while (std::getline(stream, line)) {
-        std::istringstream linestream(line);
-        std::string command;
-        linestream >> command;
-
-        if (command == "G0" || command == "G1") {
-            float x = targetPos.x;
-            float y = targetPos.y;
-            float z = targetPos.z;
-            char axis;
-            float value;
-
-            while (linestream >> axis >> value) {
-                if (axis == 'X') {
-                    x = value;
-                }
-                else if (axis == 'Y') {
-                    y = value;
-                }
-                else if (axis == 'Z') {
-                    z = value;
-                }
-            }
+    shader.Activate();
+    camera.Matrix(shader, "camMatrix");
 
-            x = std::max(minX, std::min(maxX, x));
-            y = std::max(minY, std::min(maxY, y));
-            z = std::max(minZ, std::min(maxZ, z));
+    glm::mat4 model = glm::mat4(1.0f);
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    glUniform1f(glGetUniformLocation(shader.ID, "currentTime"), currentTime);
+    glUniform3f(glGetUniformLocation(shader.ID, "positionOrigin"), buffer.positionOrigin.x, buffer.positionOrigin.y, buffer.positionOrigin.z);
+    glUniform3f(glGetUniformLocation(shader.ID, "positionScale"), buffer.positionScale.x, buffer.positionScale.y, buffer.positionScale.z);
+    glUniform1i(glGetUniformLocation(shader.ID, "colorMode"), colorMode);
+    glUniform1f(glGetUniformLocation(shader.ID, "layerCount"), (float)buffer.layerCount);
+    glUniform1i(glGetUniformLocation(shader.ID, "colorLut"), lut.unit);
+    glUniform1i(glGetUniformLocation(shader.ID, "points"), buffer.unit);
+    glUniform1i(glGetUniformLocation(shader.ID, "beads"), buffer.unit + 1);
+    glUniform4f(glGetUniformLocation(shader.ID, "streamColor"), streamColor.r, streamColor.g, streamColor.b, streamColor.a);
+    setToolColors(shader);
+}
 
-            //new target position to the queue
-            targets.push(glm::vec3(x, y, z));
+// Draws the shown streams of the uploaded toolpath in layers firstLayer..lastLayer up to the playback time.
+// The visible ranges of every stream are collected into its list, see ToolpathBuffer::Collect, and go out
+// in one call. Extrusions take colorMode: tool colors come from the tool bits of every point, the other
+// modes look the colors up in lut, the feature palette or the gradient. With tubes every extrusion is a
+// square tube. Travels and retracts are lines in their stream color, retracts also get a point as most
+// of them do not move the head. Returns the number of points drawn.
+size_t drawToolpath(Shader& lineShader, Shader& tubeShader, Camera& camera, ToolpathBuffer& buffer, ToolpathDrawList* lists,
+    const bool* shown, float currentTime, int firstLayer, int lastLayer, float pixelsPerUnit, float maxErrorPixels,
+    ColorMode colorMode, ColorLut& lut, bool tubes)
+{
+    Frustum frustum(camera.cameraMatrix);
+    lut.Bind();
+    size_t drawn = 0;
+    for (int stream = 0; stream < moveStreams; stream++) {
+        ToolpathDrawList& list = lists[stream];
+        if (!shown[stream])
+            continue;
+        buffer.Collect((MoveStream)stream, frustum, camera.Position, firstLayer, lastLayer, pixelsPerUnit, maxErrorPixels, list);
+        if (list.size() == 0)
+            continue;
+        drawn += list.points;
+
+        bool streamTubes = tubes && stream == STREAM_EXTRUDE;
+        setToolpathUniforms(streamTubes ? tubeShader : lineShader, camera, buffer, currentTime,
+            stream == STREAM_EXTRUDE ? colorMode : COLOR_STREAM, lut, streamColors[stream]);
+        buffer.Bind();
+        if (streamTubes)
+            buffer.DrawTubes(list);
+        else {
+            buffer.DrawLines(list);
+            if (stream == STREAM_RETRACT) {
+                glPointSize(5.0f);
+                buffer.DrawPoints(list);
+                glPointSize(1.0f);
+            }
         }
     }
+    buffer.Unbind();
+    lut.Unbind();
+    return drawn;
+}
+
+// Parses, plans and estimates the program with the same code as the batch simulator
+// and uploads its moves for playback, starting from startPos with startTool. bvh is built for picking.
+void executeGcode(const char* gcode, const PrinterProfile& profile, glm::vec3 startPos, int startTool, SimulationJob& job,
+    ToolpathBuffer& buffer, ToolpathBvh& bvh)
+{
+    GcodeParser parser(profile);
+    parser.position = startPos;
+    parser.tool = startTool;
+
+    job.toolpath.clear();
+    job.checkpoints.clear();
+    parseWithCheckpoints(parser, gcode, strlen(gcode), job.toolpath, job.checkpoints);
+    finishSimulation(parser, profile, job);
+
+    buffer.Upload(job.toolpath, job.plan, job.flow, profile);
+    bvh.clear();
+    bvh.append(job.toolpath);
+}
+
+// Text of a source line of the program, found from the last checkpoint before the move it made
+std::string programLine(const std::string& program, const CheckpointTable& checkpoints, size_t move, int line)
+{
+    const Checkpoint* checkpoint = checkpoints.beforeMove(move);
+    size_t offset = checkpoint != NULL ? checkpoint->offset : 0;
+    int number = checkpoint != NULL ? checkpoint->parser.lineNumber + 1 : 1;
+    while (number < line && offset < program.size()) {
+        size_t next = program.find('\n', offset);
+        offset = next == std::string::npos ? program.size() : next + 1;
+        number++;
+    }
+    size_t end = std::min(program.find('\n', offset), program.size());
+    return program.substr(offset, end - offset);
 }
 
 int main()
@@ -182,6 +439,9 @@ int main()
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     char gcodeInputText[1024] = "";
+    char gcodeFilePath[260] = "";
+    std::string gcodeFileText;
+    std::string gcodeFileError;
 
     GLFWwindow* window = glfwCreateWindow(width, height, "OpenGL", NULL, NULL);
     if (window == NULL)
@@ -210,6 +470,11 @@ int main()
     Shader shaderProgram("light.vert", "light.frag");
     Shader lightShader("light.vert", "light.frag");
     Shader traceShader("trace.vert", "trace.frag");
+    // Draws the toolpath buffer as lines, same fragment shader as the live trace
+    Shader toolpathShader("toolpath.vert", "trace.frag");
+    // Draws the toolpath as extruded beads
+    Shader tubeShader("tube.vert", "tube.frag");
+    Shader gridShader("grid.vert", "grid.frag");
 
     std::vector<Vertex> verts(vertices, vertices + sizeof(vertices) / sizeof(Vertex));
     std::vector<GLuint> ind(indices, indices + sizeof(indices) / sizeof(GLuint));
@@ -220,9 +485,25 @@ int main()
     std::vector<GLuint> lightInd(lightIndices, lightIndices + sizeof(lightIndices) / sizeof(GLuint));
     Mesh light(lightVerts, lightInd, tex);
 
+    //trace of every tool of this machine
+    std::vector<ToolTrace> toolTraces;
+    int activeTool = 0;
+    // Tool the trace was last extended with, a change starts a new strip
+    int traceTool = -1;
+    // GPU copy of every tool's trace, created when the tool draws its first strip
+    std::vector<TraceBuffer> traceBuffers;
+    // Trace history over the memory budget goes to a temporary file, ranges of it can be loaded back
+    int traceBudgetMB = 64;
+    TraceSpill traceSpill;
+    // Set when the spill file could not be written, the trace then grows past the budget
+    bool traceSpillFailed = false;
+    std::vector<ToolTrace> historyTraces;
+    std::vector<TraceBuffer> historyBuffers;
+    float historyMinY = 0.0f;
+    float historyMaxY = 2.0f;
+
     glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 0.0f);
-    targetPos = lightPos;
     glm::mat4 lightModel = glm::mat4(1.0f);
     lightModel = glm::translate(lightModel, lightPos);
 
@@ -253,6 +534,67 @@ int main()
     float minZ = -floorScale;
     float maxZ = floorScale;
 
+    PrinterProfile profile;
+    profile.bedMin = glm::vec3(minX, minY, minZ);
+    profile.bedMax = glm::vec3(maxX, maxY, maxZ);
+    // Grid over the whole bed, its lines come from the shader so nothing is uploaded per frame
+    BedGrid bedGrid;
+    bedGrid.SetBed(gridShader, profile.bedMin, profile.bedMax);
+    // Runs the limit check of loaded programs across the cores
+    ThreadPool pool;
+    SimulationJob gcodeJob;
+    gcodeJob.options.checkpoints = true;
+    gcodeJob.options.limits = true;
+    gcodeJob.options.pool = &pool;
+    bool gcodeExecuted = false;
+    // The executed program sits on the GPU, playback only moves the time forward
+    // Points and beads of the toolpath on texture units 3 and 4, after the color tables
+    ToolpathBuffer toolpathBuffer(3);
+    double playbackTime = 0.0;
+    float playbackSpeed = 1.0f;
+    bool playbackPaused = false;
+    // Layers of the program that are drawn
+    int shownLayerMin = 0;
+    int shownLayerMax = 0;
+    size_t drawnPoints = 0;
+    // Ranges drawn of every stream, a hidden stream is simply not collected
+    ToolpathDrawList toolpathDrawLists[moveStreams];
+    // Clicking the toolpath picks the move under the cursor, the program text shows its line
+    ToolpathBvh toolpathBvh;
+    std::string executedProgram;
+    ToolpathPick pick;
+    bool hasPick = false;
+    bool pickButtonHeld = false;
+    // Cuts through the floor and the toolpath, the layer range still applies on top
+    SectionPlane sectionPlanes[sectionPlaneCount];
+    bool showStreams[moveStreams] = { true, true, true };
+    // Largest error on screen a simplified level may have, 0 always draws full detail
+    float lodErrorPixels = 1.0f;
+    // Color tables of the toolpath on texture unit 2, after the mesh textures
+    int colorMode = COLOR_TOOL;
+    bool showTubes = false;
+    ColorLut gradientLut(colorGradient(gradientStops, 256), true, 2);
+    // Gray for moves without a feature, then a tool color per feature
+    std::vector<glm::vec4> featureColors(16);
+    featureColors[0] = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+    for (int feature = 1; feature < 16; feature++) {
+        featureColors[feature] = toolColor(feature - 1);
+    }
+    ColorLut featureLut(featureColors, false, 2);
+    double lastFrameTime = glfwGetTime();
+    int rewindLayer = 0;
+
+    // Jog sessions recorded from the arrow keys and played back tick by tick
+    char jogLogPath[260] = "jog.bin";
+    std::string jogLogMessage;
+    JogLog jogRecord;
+    bool jogRecording = false;
+    double jogRecordStart = 0.0;
+    JogLog jogReplay;
+    bool jogReplaying = false;
+    size_t jogReplayRun = 0;
+    uint32_t jogReplayTick = 0;
+
     //ImGui
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -267,10 +609,14 @@ int main()
 
     static bool controlModeArrows = true;
 
-    const float moveSpeed = 0.01f;  // Speed of cube movement
+    const float moveSpeed = 0.01f;  // Distance the cube jogs per frame
 
     while (!glfwWindowShouldClose(window))
     {
+        double frameTime = glfwGetTime();
+        double frameDelta = frameTime - lastFrameTime;
+        lastFrameTime = frameTime;
+
         glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -281,64 +627,96 @@ int main()
         {
             camera.Inputs(window);
         }
-        camera.updateMatrix(45.0f, 0.1f, 100.0f);
+        camera.updateMatrix(fieldOfView, 0.1f, 100.0f);
+
+        // A click outside the panels without Alt picks the printed move under the cursor among the shown ones
+        bool pickButton = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (pickButton && !pickButtonHeld && !altPressed && !ImGui::GetIO().WantCaptureMouse && gcodeExecuted) {
+            double cursorX, cursorY;
+            glfwGetCursorPos(window, &cursorX, &cursorY);
+            glm::vec2 ndc(2.0f * (float)cursorX / width - 1.0f, 1.0f - 2.0f * (float)cursorY / height);
+            glm::mat4 inverse = glm::inverse(camera.cameraMatrix);
+            glm::vec4 nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+            glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+            glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - glm::vec3(nearPoint) / nearPoint.w);
+            float angle = pickPixels * 2.0f * std::tan(glm::radians(fieldOfView) / 2.0f) / height;
+
+            PickFilter filter;
+            filter.firstLayer = shownLayerMin;
+            filter.lastLayer = shownLayerMax;
+            filter.moveEnd = gcodeJob.plan.moveAtTime(playbackTime) + 1;
+            std::copy(showStreams, showStreams + moveStreams, filter.streams);
+            for (int i = 0; i < sectionPlaneCount; i++) {
+                if (sectionPlanes[i].enabled)
+                    filter.planes.push_back(sectionPlanes[i].equation());
+            }
+            hasPick = toolpathBvh.pick(gcodeJob.toolpath, camera.Position, direction, angle, filter, pick);
+        }
+        pickButtonHeld = pickButton;
 
         // cube position via G-code
         if (!controlModeArrows)
         {
-            if (!gcodeTargets.empty())
+            // The head is interpolated along the move running at the playback time
+            const MotionPlan& plan = gcodeJob.plan;
+            if (gcodeExecuted && plan.size() > 0)
             {
-                glm::vec3 target = gcodeTargets.front();
-                glm::vec3 direction = target - lightPos;
-                float distance = glm::length(direction);
-
-                if (distance > moveSpeed)
+                if (!playbackPaused)
                 {
-                    direction = glm::normalize(direction);
-                    lightPos += direction * moveSpeed;
+                    playbackTime = std::min(playbackTime + frameDelta * playbackSpeed, plan.totalTime);
                 }
-                else
+                const Toolpath& toolpath = gcodeJob.toolpath;
+                size_t move = std::min(plan.moveAtTime(playbackTime), plan.size() - 1);
+                float progress = 1.0f;
+                if (plan.duration[move] > 0.0f)
                 {
-                    lightPos = target;
-                    gcodeTargets.pop();
+                    progress = glm::clamp((float)((playbackTime - plan.startTime(move)) / plan.duration[move]), 0.0f, 1.0f);
                 }
-
-                pastPositions.push_back(lightPos);
-
-                targetPos = lightPos;
+                lightPos = glm::mix(toolpath.startOf(move), toolpath.position(move), progress);
+                activeTool = toolpath.tool[move];
             }
         }
         else
         {
-            lightVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
-            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS && lightPos.z - 0.01f >= minZ) {
-                lightVelocity.z = -0.01f;
-            }
-            if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS && lightPos.z + 0.01f <= maxZ) {
-                lightVelocity.z = 0.01f;
-            }
-            if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS && lightPos.x - 0.01f >= minX) {
-                lightVelocity.x = -0.01f;
-            }
-            if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS && lightPos.x + 0.01f <= maxX) {
-                lightVelocity.x = 0.01f;
-            }
-            if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS && lightPos.y + 0.01f <= maxY) {
-                lightVelocity.y = 0.01f;
+            // Held keys of this tick, a replay takes them from the log instead of the keyboard
+            unsigned char jogKeys = 0;
+            if (jogReplaying) {
+                while (jogReplayRun < jogReplay.runs.size() && jogReplayTick >= jogReplay.runs[jogReplayRun].ticks) {
+                    jogReplayRun++;
+                    jogReplayTick = 0;
+                }
+                if (jogReplayRun < jogReplay.runs.size()) {
+                    jogKeys = jogReplay.runs[jogReplayRun].keys;
+                    jogReplayTick++;
+                }
+                else {
+                    jogReplaying = false;
+                }
             }
-            if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS && lightPos.y - 0.01f >= minY) {
-                lightVelocity.y = -0.01f;
+            else {
+                if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) jogKeys |= JOG_Z_MINUS;
+                if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) jogKeys |= JOG_Z_PLUS;
+                if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) jogKeys |= JOG_X_MINUS;
+                if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) jogKeys |= JOG_X_PLUS;
+                if (glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS) jogKeys |= JOG_Y_PLUS;
+                if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS) jogKeys |= JOG_Y_MINUS;
+                if (jogRecording) {
+                    jogRecord.addTick(jogKeys);
+                }
             }
 
-            lightPos += lightVelocity;
+            // A replay stays within the recorded bed, the profile's bed is left alone for everything else
+            glm::vec3 jogMin = jogReplaying ? jogReplay.bedMin : profile.bedMin;
+            glm::vec3 jogMax = jogReplaying ? jogReplay.bedMax : profile.bedMax;
+            glm::vec3 jogPos = jogStep(lightPos, jogKeys, jogMin, jogMax, moveSpeed);
+            lightVelocity = jogPos - lightPos;
+            lightPos = jogPos;
 
             // past positions for the trace
             if (lightVelocity != glm::vec3(0.0f, 0.0f, 0.0f)) {
-                pastPositions.push_back(lightPos);
+                addTracePoint(toolTraces, activeTool, lightPos, activeTool != traceTool);
+                traceTool = activeTool;
             }
-
-            // Reset target position after arrow key control
-            targetPos = lightPos;
         }
 
         lightModel = glm::mat4(1.0f);
@@ -346,16 +724,56 @@ int main()
         lightShader.Activate();
         glUniformMatrix4fv(glGetUniformLocation(lightShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(lightModel));
 
+        // Section planes cut the floor and everything the trace, toolpath and tube shaders draw
+        setSectionPlanes(shaderProgram, sectionPlanes);
+        setSectionPlanes(traceShader, sectionPlanes);
+        setSectionPlanes(toolpathShader, sectionPlanes);
+        setSectionPlanes(tubeShader, sectionPlanes);
+        setSectionPlanes(gridShader, sectionPlanes);
+        for (int i = 0; i < sectionPlaneCount; i++) {
+            if (sectionPlanes[i].enabled) {
+                glEnable(GL_CLIP_DISTANCE0 + i);
+            }
+        }
+
         shaderProgram.Activate();
         glUniform3f(glGetUniformLocation(shaderProgram.ID, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
 
         floor.Draw(shaderProgram, camera);
 
-        drawCoordinateLines(shaderProgram, camera, floorScale);
+        bedGrid.Draw(gridShader, camera);
 
-        drawTrace(traceShader, camera, pastPositions);
+        size_t traceBudget = (size_t)traceBudgetMB * 1024 * 1024 / sizeof(glm::vec3);
+        if (!traceSpillFailed) {
+            traceSpillFailed = !enforceTraceBudget(toolTraces, traceSpill, traceBudget);
+        }
+        drawTrace(traceShader, camera, toolTraces, traceBuffers);
+        drawTrace(traceShader, camera, historyTraces, historyBuffers);
+        if (gcodeExecuted) {
+            drawnPoints = drawToolpath(toolpathShader, tubeShader, camera, toolpathBuffer, toolpathDrawLists, showStreams,
+                (float)playbackTime, shownLayerMin, shownLayerMax,
+                height / (2.0f * std::tan(glm::radians(fieldOfView) / 2.0f)), lodErrorPixels,
+                (ColorMode)colorMode, colorMode == COLOR_FEATURE ? featureLut : gradientLut, showTubes);
+        }
+        // The tool cubes and the panels are never cut
+        for (int i = 0; i < sectionPlaneCount; i++) {
+            glDisable(GL_CLIP_DISTANCE0 + i);
+        }
 
-        light.Draw(lightShader, camera);
+        // A cube per tool, the idle ones sit at their offset from the active nozzle
+        int toolCount = std::max((int)profile.toolOffsets.size(), activeTool + 1);
+        if (gcodeExecuted) {
+            toolCount = std::max(toolCount, gcodeJob.toolpath.toolCount);
+        }
+        lightShader.Activate();
+        for (int tool = 0; tool < toolCount; tool++) {
+            glm::vec3 toolPos = lightPos + profile.toolOffset(tool) - profile.toolOffset(activeTool);
+            glm::vec4 color = toolColor(tool) * (tool == activeTool ? 1.0f : 0.4f);
+            lightModel = glm::translate(glm::mat4(1.0f), toolPos);
+            glUniformMatrix4fv(glGetUniformLocation(lightShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(lightModel));
+            glUniform4f(glGetUniformLocation(lightShader.ID, "lightColor"), color.r, color.g, color.b, 1.0f);
+            light.Draw(lightShader, camera);
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -368,10 +786,263 @@ int main()
 
         controlModeArrows = (selected == 0);
 
+        size_t traceVertices = 0;
+        for (const ToolTrace& trace : toolTraces) {
+            traceVertices += trace.positions.size();
+        }
+        ImGui::Text("Trace: %d vertices", (int)traceVertices);
+
+        // Section planes, the normal is turned around the vertical axis and tilted up, the offset moves the plane along it
+        for (int i = 0; i < sectionPlaneCount; i++) {
+            SectionPlane& plane = sectionPlanes[i];
+            ImGui::PushID(i);
+            std::string label = "Section Plane " + std::to_string(i + 1);
+            ImGui::Checkbox(label.c_str(), &plane.enabled);
+            if (plane.enabled) {
+                ImGui::SliderFloat("Azimuth", &plane.azimuth, -180.0f, 180.0f, "%.0f deg");
+                ImGui::SliderFloat("Elevation", &plane.elevation, -90.0f, 90.0f, "%.0f deg");
+                ImGui::SliderFloat("Offset", &plane.offset, -floorScale, floorScale, "%.2f");
+            }
+            ImGui::PopID();
+        }
+        if (ImGui::InputInt("Trace Budget (MB)", &traceBudgetMB)) {
+            traceBudgetMB = std::max(traceBudgetMB, 1);
+        }
+        if (traceSpillFailed) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Trace spill file cannot be written, the trace stays in memory");
+        }
+        // Spilled history, loaded back by height so earlier layers can be inspected again
+        if (!traceSpill.chunks.empty()) {
+            ImGui::Text("Spilled: %d vertices, %.1f MB on disk", (int)traceSpill.spilledVertices, traceSpill.spilledBytes / (1024.0 * 1024.0));
+            ImGui::DragFloatRange2("History Heights", &historyMinY, &historyMaxY, 0.01f, profile.bedMin.y, profile.bedMax.y);
+            if (ImGui::Button("Load History")) {
+                loadTraceHistory(traceSpill, historyMinY, historyMaxY, traceBudget, historyTraces);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Hide History")) {
+                historyTraces.clear();
+            }
+        }
+
+        if (controlModeArrows) {
+            ImGui::InputText("Jog Log", jogLogPath, IM_ARRAYSIZE(jogLogPath));
+            if (!jogRecording && !jogReplaying && ImGui::Button("Start Recording")) {
+                jogRecord = JogLog();
+                jogRecord.start = lightPos;
+                jogRecord.bedMin = profile.bedMin;
+                jogRecord.bedMax = profile.bedMax;
+                jogRecord.step = moveSpeed;
+                jogRecordStart = glfwGetTime();
+                jogRecording = true;
+                jogLogMessage.clear();
+            }
+            else if (jogRecording && ImGui::Button("Stop Recording")) {
+                // Frame rate of the session, lets the exported G-code run as fast as the cube did
+                double seconds = glfwGetTime() - jogRecordStart;
+                uint64_t ticks = jogRecord.tickCount();
+                if (seconds > 0.0 && ticks > 0) {
+                    jogRecord.ticksPerSecond = (float)(ticks / seconds);
+                }
+                jogRecording = false;
+                if (writeJogLog(jogLogPath, jogRecord)) {
+                    jogLogMessage = "Saved " + std::to_string(ticks) + " ticks";
+                }
+                else {
+                    jogLogMessage = std::string("Cannot write ") + jogLogPath;
+                }
+            }
+            if (!jogRecording && !jogReplaying) {
+                ImGui::SameLine();
+                if (ImGui::Button("Replay")) {
+                    if (readJogLog(jogLogPath, jogReplay)) {
+                        // Same start and bounds as the recording so the cube retraces it exactly
+                        toolTraces.clear();
+                        historyTraces.clear();
+                        traceSpill.clear();
+                        traceSpillFailed = false;
+                        lightPos = jogReplay.start;
+                        jogReplayRun = 0;
+                        jogReplayTick = 0;
+                        jogReplaying = true;
+                        jogLogMessage.clear();
+                    }
+                    else {
+                        jogLogMessage = std::string("Cannot read ") + jogLogPath;
+                    }
+                }
+            }
+            if (jogRecording) {
+                ImGui::Text("Recording: %d ticks", (int)jogRecord.tickCount());
+            }
+            if (jogReplaying) {
+                ImGui::Text("Replaying: run %d of %d", (int)jogReplayRun + 1, (int)jogReplay.runs.size());
+            }
+            if (!jogLogMessage.empty()) {
+                ImGui::Text("%s", jogLogMessage.c_str());
+            }
+        }
+
         if (!controlModeArrows) {
             ImGui::InputTextMultiline("G-code Input", gcodeInputText, IM_ARRAYSIZE(gcodeInputText), ImVec2(-FLT_MIN, ImGui::GetTextLineHeight() * 16));
+            // New programs start where the head is
+            glm::vec3 startPos = lightPos;
+            int startTool = activeTool;
             if (ImGui::Button("Execute")) {
-                executeGcode(gcodeInputText, gcodeTargets, minX, maxX, minY, maxY, minZ, maxZ);
+                executeGcode(gcodeInputText, profile, startPos, startTool, gcodeJob, toolpathBuffer, toolpathBvh);
+                executedProgram = gcodeInputText;
+                hasPick = false;
+                gcodeExecuted = true;
+                playbackTime = 0.0;
+                shownLayerMin = 0;
+                shownLayerMax = toolpathBuffer.layerCount - 1;
+            }
+
+            // Nozzle offsets of the tools the last program used, relative to T0
+            if (gcodeExecuted && gcodeJob.toolpath.toolCount > 1) {
+                if ((int)profile.toolOffsets.size() < gcodeJob.toolpath.toolCount) {
+                    profile.toolOffsets.resize(gcodeJob.toolpath.toolCount, glm::vec3(0.0f));
+                }
+                for (int tool = 1; tool < gcodeJob.toolpath.toolCount; tool++) {
+                    std::string label = "T" + std::to_string(tool) + " Offset";
+                    ImGui::InputFloat3(label.c_str(), &profile.toolOffsets[tool].x);
+                }
+            }
+
+            ImGui::InputText("G-code File", gcodeFilePath, IM_ARRAYSIZE(gcodeFilePath));
+            if (ImGui::Button("Load File")) {
+                if (readTextFile(gcodeFilePath, gcodeFileText)) {
+                    executeGcode(gcodeFileText.c_str(), profile, startPos, startTool, gcodeJob, toolpathBuffer, toolpathBvh);
+                    executedProgram.swap(gcodeFileText);
+                    hasPick = false;
+                    gcodeExecuted = true;
+                    playbackTime = 0.0;
+                    shownLayerMin = 0;
+                    shownLayerMax = toolpathBuffer.layerCount - 1;
+                    gcodeFileError.clear();
+                }
+                else {
+                    gcodeFileError = std::string("Cannot read ") + gcodeFilePath;
+                }
+            }
+            if (!gcodeFileError.empty()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", gcodeFileError.c_str());
+            }
+
+            if (gcodeExecuted) {
+                const SimulationStats& stats = gcodeJob.stats;
+                ImGui::Separator();
+                float playbackSlider = (float)playbackTime;
+                if (ImGui::SliderFloat("Time", &playbackSlider, 0.0f, (float)gcodeJob.plan.totalTime, "%.1f s")) {
+                    playbackTime = playbackSlider;
+                }
+                if (ImGui::Button(playbackPaused ? "Play" : "Pause")) {
+                    playbackPaused = !playbackPaused;
+                }
+                ImGui::SameLine();
+                ImGui::SliderFloat("Speed", &playbackSpeed, 0.1f, 100.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+                // Only the chosen layers are drawn, each is a range of the uploaded buffer
+                if (toolpathBuffer.layerCount > 1) {
+                    ImGui::DragIntRange2("Shown Layers", &shownLayerMin, &shownLayerMax, 0.2f, 0, toolpathBuffer.layerCount - 1);
+                }
+                GLsizei bufferPoints = 0;
+                for (GLsizei count : toolpathBuffer.toolCount) {
+                    bufferPoints += count;
+                }
+                ImGui::Text("Drawn: %d of %d points", (int)drawnPoints, (int)bufferPoints);
+                ImGui::SliderFloat("LOD Error (px)", &lodErrorPixels, 0.0f, 8.0f, "%.1f");
+                for (int stream = 0; stream < moveStreams; stream++) {
+                    if (stream > 0) {
+                        ImGui::SameLine();
+                    }
+                    ImGui::Checkbox(streamNames[stream], &showStreams[stream]);
+                }
+                ImGui::Checkbox("Extrusion Tubes", &showTubes);
+                ImGui::Combo("Color By", &colorMode, colorModeNames, IM_ARRAYSIZE(colorModeNames));
+                // Legend of the chosen coloring, the gradient runs from its first stop to its last
+                if (colorMode == COLOR_FEATURE) {
+                    for (size_t feature = 0; feature <= gcodeJob.toolpath.featureNames.size() && feature < 16; feature++) {
+                        glm::vec4 color = featureColors[feature];
+                        ImGui::TextColored(ImVec4(color.r, color.g, color.b, color.a), "%s",
+                            feature == 0 ? "(none)" : gcodeJob.toolpath.featureNames[feature - 1].c_str());
+                    }
+                }
+                else if (colorMode != COLOR_TOOL) {
+                    glm::vec4 low = gradientStops.front();
+                    glm::vec4 high = gradientStops.back();
+                    float top = colorMode == COLOR_SPEED ? toolpathBuffer.speedMax
+                        : colorMode == COLOR_FLOW ? toolpathBuffer.flowMax
+                        : colorMode == COLOR_LAYER ? (float)(toolpathBuffer.layerCount - 1) : 255.0f;
+                    ImGui::TextColored(ImVec4(low.r, low.g, low.b, low.a), "0");
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(high.r, high.g, high.b, high.a), "%.1f %s", top,
+                        colorMode == COLOR_SPEED ? "units/s" : colorMode == COLOR_FLOW ? "mm^3/s" : "");
+                }
+                // The picked move and the line it came from
+                if (hasPick) {
+                    const Toolpath& toolpath = gcodeJob.toolpath;
+                    size_t move = pick.move;
+                    ImGui::Text("Picked line %d, layer %d, feedrate %.1f units/s, flow %.2f mm^3/s", toolpath.line[move],
+                        toolpath.layer[move], toolpath.feedrate[move], gcodeJob.flow[move]);
+                    std::string line = programLine(executedProgram, gcodeJob.checkpoints, move, toolpath.line[move]);
+                    ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.1f, 1.0f), "%s", line.c_str());
+                    if (ImGui::Button("Play From Picked Move")) {
+                        playbackTime = gcodeJob.plan.startTime(move);
+                    }
+                }
+                ImGui::Text("Estimated time: %.1f s (heating %.1f s)", stats.printTime, stats.heatingTime);
+                ImGui::Text("Filament: %.2f mm", stats.filamentLength);
+                ImGui::Text("Layers: %d  Moves: %d", (int)stats.layerCount, (int)stats.moveCount);
+                if (stats.toolChanges > 0) {
+                    ImGui::Text("Tool changes: %d (%.1f s)", (int)stats.toolChanges, stats.toolChangeTime);
+                }
+                ImGui::Text("Out of bounds moves: %d", (int)stats.outOfBoundsMoves);
+
+                // Moves that ask an axis for more than the profile allows, the planner slows them down
+                const LimitReport& limits = gcodeJob.limits;
+                if (!limits.violations.empty()) {
+                    size_t kindTotals[3] = { 0, 0, 0 };
+                    for (int kind = 0; kind < 3; kind++) {
+                        for (int axis = 0; axis < 4; axis++) {
+                            kindTotals[kind] += limits.counts[kind][axis];
+                        }
+                    }
+                    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "Over limits: velocity %d, acceleration %d, jerk %d",
+                        (int)kindTotals[LIMIT_VELOCITY], (int)kindTotals[LIMIT_ACCELERATION], (int)kindTotals[LIMIT_JERK]);
+                    static const char* axisNames = "XYZE";
+                    static const char* kindNames[3] = { "velocity", "acceleration", "jerk" };
+                    size_t listed = std::min<size_t>(limits.violations.size(), 5);
+                    for (size_t i = 0; i < listed; i++) {
+                        const LimitViolation& violation = limits.violations[i];
+                        ImGui::Text("  line %d: %c %s %.1f > %.1f", violation.line, axisNames[violation.axis],
+                            kindNames[violation.kind], violation.requested, violation.limit);
+                    }
+                }
+
+                // Extruding moves by volumetric flow, the bins past the melt limit are where parts under-extrude
+                const FlowStats& flowStats = gcodeJob.flowStats;
+                float flowHistogram[FlowStats::histogramBins];
+                for (int bin = 0; bin < FlowStats::histogramBins; bin++) {
+                    flowHistogram[bin] = (float)flowStats.histogram[bin];
+                }
+                ImGui::Text("Flow: peak %.1f, average %.1f mm3/s (limit %.1f)", flowStats.peakFlow, flowStats.averageFlow, flowStats.limit);
+                ImGui::PlotHistogram("Flow", flowHistogram, FlowStats::histogramBins, 0, NULL, 0.0f, FLT_MAX, ImVec2(0, 80));
+                if (!flowStats.violations.empty()) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%d moves over the melt limit, first on line %d", (int)flowStats.violations.size(), flowStats.violations[0].line);
+                }
+
+                // Moves playback to the start of a layer, the checkpoint tells where it begins. The viewer keeps
+                // the whole simulated job, so it only seeks, BatchSim --from-layer restarts the printer there.
+                if (stats.layerCount > 0) {
+                    ImGui::SliderInt("Layer", &rewindLayer, 0, (int)stats.layerCount - 1);
+                    const Checkpoint* checkpoint = gcodeJob.checkpoints.atLayer((size_t)rewindLayer);
+                    if (checkpoint != NULL && ImGui::Button("Seek To Layer")) {
+                        playbackTime = gcodeJob.plan.startTime(std::min(checkpoint->move, gcodeJob.plan.size()));
+                    }
+                    if (checkpoint != NULL) {
+                        const ParserState& state = checkpoint->parser;
+                        ImGui::Text("Line %d at %.1f s, hotend %.0f, bed %.0f", state.lineNumber + 1, checkpoint->time, state.hotendTemperature, state.bedTemperature);
+                    }
+                }
             }
         }
 
@@ -391,6 +1062,19 @@ int main()
     shaderProgram.Delete();
     lightShader.Delete();
     traceShader.Delete();
+    toolpathShader.Delete();
+    tubeShader.Delete();
+    gridShader.Delete();
+    bedGrid.Delete();
+    for (TraceBuffer& buffer : traceBuffers) {
+        buffer.Delete();
+    }
+    for (TraceBuffer& buffer : historyBuffers) {
+        buffer.Delete();
+    }
+    toolpathBuffer.Delete();
+    gradientLut.Delete();
+    featureLut.Delete();
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
@@ -0,0 +1,202 @@
+#include"Planner.h"
+
+#include<algorithm>
+#include<cmath>
+
+// Unit direction of a move in (X, Y, Z, E), zero for moves that go nowhere
+static glm::vec4 moveDirection(const Toolpath& toolpath, size_t i, float& length)
+{
+	glm::vec3 delta = toolpath.position(i) - toolpath.startOf(i);
+	float deltaE = toolpath.e[i] - toolpath.startEOf(i);
+	length = glm::length(delta);
+	// Extruder only moves (retracts, primes) are measured along E
+	if (length < 1e-6f)
+		length = std::fabs(deltaE);
+	if (length < 1e-6f)
+	{
+		length = 0.0f;
+		return glm::vec4(0.0f);
+	}
+	return glm::vec4(delta, deltaE) / length;
+}
+
+// Highest speed at which a move along direction can start from or stop to rest
+static float restJunctionSpeed(const glm::vec4& direction, const PrinterProfile& profile, float speed)
+{
+	for (int axis = 0; axis < 4; axis++)
+	{
+		float component = std::fabs(direction[axis]);
+		if (component * speed > profile.maxJerk[axis])
+			speed = profile.maxJerk[axis] / component;
+	}
+	return speed;
+}
+
+// Time after the start of move i at which distance along it has been covered
+float MotionPlan::timeAtDistance(size_t i, float distance) const
+{
+	float entry = entrySpeed[i];
+	float cruise = cruiseSpeed[i];
+	float exit = exitSpeed[i];
+	float accel = acceleration[i];
+	if (length[i] == 0.0f || cruise == 0.0f)
+		return 0.0f;
+
+	float accelDistance = (cruise * cruise - entry * entry) / (2.0f * accel);
+	float decelDistance = (cruise * cruise - exit * exit) / (2.0f * accel);
+	float cruiseDistance = std::max(0.0f, length[i] - accelDistance - decelDistance);
+	float accelTime = (cruise - entry) / accel;
+
+	if (distance <= accelDistance)
+		return (std::sqrt(entry * entry + 2.0f * accel * distance) - entry) / accel;
+	distance -= accelDistance;
+	if (distance <= cruiseDistance)
+		return accelTime + distance / cruise;
+	distance = std::min(distance - cruiseDistance, decelDistance);
+	float speed = std::sqrt(std::max(0.0f, cruise * cruise - 2.0f * accel * distance));
+	return accelTime + cruiseDistance / cruise + (cruise - speed) / accel;
+}
+
+// Move running at the given time since the job started, size() once the job is done
+size_t MotionPlan::moveAtTime(double time) const
+{
+	return std::upper_bound(endTime.begin(), endTime.end(), time) - endTime.begin();
+}
+
+// Plans the whole toolpath with look-ahead over every corner and fills in the timing columns.
+// speedLimit optionally caps the cruise speed of every move, e.g. for motor limits of the kinematics.
+void planMotion(const Toolpath& toolpath, const PrinterProfile& profile, MotionPlan& plan, const std::vector<float>* speedLimit)
+{
+	size_t count = toolpath.size();
+	plan.length.resize(count);
+	plan.entrySpeed.resize(count);
+	plan.cruiseSpeed.resize(count);
+	plan.exitSpeed.resize(count);
+	plan.acceleration.resize(count);
+	plan.duration.resize(count);
+	plan.endTime.resize(count);
+	plan.totalTime = 0.0;
+	if (count == 0)
+		return;
+
+	// Nominal speed, acceleration and the highest entry speed the corner before every move allows
+	std::vector<float>& maxEntry = plan.entrySpeed;
+	glm::vec4 previousDirection(0.0f);
+	float previousSpeed = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		float length;
+		glm::vec4 direction = moveDirection(toolpath, i, length);
+		float speed = toolpath.feedrate[i];
+		if (speedLimit != NULL)
+			speed = std::min(speed, (*speedLimit)[i]);
+		float acceleration = 1e30f;
+		for (int axis = 0; axis < 4; axis++)
+		{
+			float component = std::fabs(direction[axis]);
+			if (component < 1e-6f)
+				continue;
+			speed = std::min(speed, profile.maxVelocity[axis] / component);
+			acceleration = std::min(acceleration, profile.maxAcceleration[axis] / component);
+		}
+		if (length == 0.0f)
+		{
+			speed = 0.0f;
+			acceleration = 1.0f;
+		}
+
+		// Junction speed limited by the allowed instantaneous change of every axis
+		float junction = std::min(previousSpeed, speed);
+		for (int axis = 0; axis < 4; axis++)
+		{
+			float change = std::fabs(previousDirection[axis] - direction[axis]) * junction;
+			if (change > profile.maxJerk[axis])
+				junction *= profile.maxJerk[axis] / change;
+		}
+		if (previousSpeed == 0.0f)
+			junction = restJunctionSpeed(direction, profile, speed);
+
+		plan.length[i] = length;
+		plan.cruiseSpeed[i] = speed;
+		plan.acceleration[i] = acceleration;
+		maxEntry[i] = junction;
+
+		if (length > 0.0f)
+		{
+			previousDirection = direction;
+			previousSpeed = speed;
+		}
+	}
+
+	// Backward pass: every move must be able to slow down to the next entry speed
+	float nextEntry = 0.0f;
+	for (size_t i = count; i-- > 0;)
+	{
+		float length = plan.length[i];
+		if (length == 0.0f)
+		{
+			plan.entrySpeed[i] = nextEntry;
+			plan.exitSpeed[i] = nextEntry;
+			continue;
+		}
+		// The machine stops at the end of the job
+		float exit = nextEntry;
+		if (i + 1 == count)
+		{
+			float ignored;
+			exit = restJunctionSpeed(moveDirection(toolpath, i, ignored), profile, plan.cruiseSpeed[i]);
+		}
+		plan.exitSpeed[i] = exit;
+		float reachable = std::sqrt(exit * exit + 2.0f * plan.acceleration[i] * length);
+		plan.entrySpeed[i] = std::min(maxEntry[i], reachable);
+		nextEntry = plan.entrySpeed[i];
+	}
+
+	// Forward pass: every move must be able to speed up to its exit speed, then time the trapezoids
+	float entry = plan.entrySpeed[0];
+	double time = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		float length = plan.length[i];
+		float acceleration = plan.acceleration[i];
+		if (length == 0.0f)
+		{
+			plan.entrySpeed[i] = entry;
+			plan.exitSpeed[i] = entry;
+			plan.cruiseSpeed[i] = entry;
+			plan.duration[i] = 0.0f;
+			plan.endTime[i] = time;
+			continue;
+		}
+
+		entry = std::min(entry, plan.entrySpeed[i]);
+		float exit = std::min(plan.exitSpeed[i], std::sqrt(entry * entry + 2.0f * acceleration * length));
+		float cruise = plan.cruiseSpeed[i];
+
+		float accelDistance = (cruise * cruise - entry * entry) / (2.0f * acceleration);
+		float decelDistance = (cruise * cruise - exit * exit) / (2.0f * acceleration);
+		if (accelDistance + decelDistance > length)
+		{
+			// Triangle profile, the plateau is never reached
+			cruise = std::sqrt(std::max(0.0f, (2.0f * acceleration * length + entry * entry + exit * exit) * 0.5f));
+			cruise = std::max(cruise, std::max(entry, exit));
+			accelDistance = std::max(0.0f, (cruise * cruise - entry * entry) / (2.0f * acceleration));
+			decelDistance = std::max(0.0f, length - accelDistance);
+		}
+		float cruiseDistance = std::max(0.0f, length - accelDistance - decelDistance);
+
+		float duration = (cruise - entry) / acceleration + (cruise - exit) / acceleration;
+		if (cruise > 0.0f)
+			duration += cruiseDistance / cruise;
+
+		plan.entrySpeed[i] = entry;
+		plan.cruiseSpeed[i] = cruise;
+		plan.exitSpeed[i] = exit;
+		plan.duration[i] = duration;
+		time += duration;
+		plan.endTime[i] = time;
+
+		entry = exit;
+	}
+	plan.totalTime = time;
+}
@@ -0,0 +1,39 @@
+#ifndef PLANNER_CLASS_H
+#define PLANNER_CLASS_H
+
+#include<vector>
+
+#include"Gcode.h"
+#include"PrinterProfile.h"
+
+// Trapezoidal speed profile of every move of a Toolpath, one entry per move
+struct MotionPlan
+{
+	// Travelled distance, the E distance for extruder only moves
+	std::vector<float> length;
+	// Speeds in units/s at the start, the plateau and the end of the move
+	std::vector<float> entrySpeed;
+	std::vector<float> cruiseSpeed;
+	std::vector<float> exitSpeed;
+	// Acceleration the move ramps with in units/s^2
+	std::vector<float> acceleration;
+	// Time the move takes in seconds
+	std::vector<float> duration;
+	// Time since the start of the job when the move is done
+	std::vector<double> endTime;
+
+	double totalTime = 0.0;
+
+	size_t size() const { return duration.size(); }
+	double startTime(size_t i) const { return i == 0 ? 0.0 : endTime[i - 1]; }
+	// Time after the start of move i at which distance along it has been covered
+	float timeAtDistance(size_t i, float distance) const;
+	// Move running at the given time since the job started, size() once the job is done
+	size_t moveAtTime(double time) const;
+};
+
+// Plans the whole toolpath with look-ahead over every corner and fills in the timing columns.
+// speedLimit optionally caps the cruise speed of every move, e.g. for motor limits of the kinematics.
+void planMotion(const Toolpath& toolpath, const PrinterProfile& profile, MotionPlan& plan, const std::vector<float>* speedLimit = NULL);
+
+#endif
@@ -0,0 +1,218 @@
+#include"PrinterProfile.h"
+
+#include<fstream>
+#include<sstream>
+#include<iostream>
+
+// Reads up to count floats from the stream, returns how many were read
+static int readFloats(std::istringstream& stream, float* values, int count)
+{
+	int read = 0;
+	while (read < count && stream >> values[read])
+		read++;
+	return read;
+}
+
+// Reads "key = value" lines into the profile, unknown keys are reported and skipped
+bool loadPrinterProfile(const char* filename, PrinterProfile& profile)
+{
+	std::ifstream in(filename);
+	if (!in)
+	{
+		std::cerr << "Failed to open printer profile " << filename << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		// Strips comments and skips empty lines
+		size_t comment = line.find_first_of("#;");
+		if (comment != std::string::npos)
+			line.erase(comment);
+		size_t equals = line.find('=');
+		if (equals == std::string::npos)
+			continue;
+
+		std::string key;
+		std::istringstream keyStream(line.substr(0, equals));
+		keyStream >> key;
+		std::istringstream value(line.substr(equals + 1));
+
+		int expected = 1;
+		int read = 0;
+		// Values the simulation divides by, zero or less would turn its times into inf or NaN
+		float* positive = NULL;
+		if (key == "name")
+		{
+			read = (value >> profile.name) ? 1 : 0;
+		}
+		else if (key == "bed_min")
+		{
+			expected = 3;
+			read = readFloats(value, &profile.bedMin.x, 3);
+		}
+		else if (key == "bed_max")
+		{
+			expected = 3;
+			read = readFloats(value, &profile.bedMax.x, 3);
+		}
+		else if (key == "max_velocity")
+		{
+			positive = &profile.maxVelocity.x;
+			expected = 4;
+			read = readFloats(value, &profile.maxVelocity.x, 4);
+		}
+		else if (key == "max_acceleration")
+		{
+			positive = &profile.maxAcceleration.x;
+			expected = 4;
+			read = readFloats(value, &profile.maxAcceleration.x, 4);
+		}
+		else if (key == "max_jerk")
+		{
+			expected = 4;
+			read = readFloats(value, &profile.maxJerk.x, 4);
+		}
+		else if (key == "default_feedrate")
+		{
+			positive = &profile.defaultFeedrate;
+			read = readFloats(value, &profile.defaultFeedrate, 1);
+		}
+		else if (key == "filament_diameter")
+		{
+			positive = &profile.filamentDiameter;
+			read = readFloats(value, &profile.filamentDiameter, 1);
+		}
+		else if (key == "max_volumetric_flow")
+		{
+			positive = &profile.maxVolumetricFlow;
+			read = readFloats(value, &profile.maxVolumetricFlow, 1);
+		}
+		else if (key == "line_width")
+		{
+			positive = &profile.lineWidth;
+			read = readFloats(value, &profile.lineWidth, 1);
+		}
+		else if (key == "layer_height")
+		{
+			positive = &profile.layerHeight;
+			read = readFloats(value, &profile.layerHeight, 1);
+		}
+		else if (key == "full_steps_per_unit")
+		{
+			positive = &profile.fullStepsPerUnit.x;
+			expected = 4;
+			read = readFloats(value, &profile.fullStepsPerUnit.x, 4);
+		}
+		else if (key == "microsteps")
+		{
+			positive = &profile.microsteps.x;
+			expected = 4;
+			read = readFloats(value, &profile.microsteps.x, 4);
+		}
+		else if (key == "max_step_rate")
+		{
+			positive = &profile.maxStepRate;
+			read = readFloats(value, &profile.maxStepRate, 1);
+		}
+		else if (key == "kinematics")
+		{
+			std::string type;
+			value >> type;
+			read = 1;
+			if (type == "cartesian")
+				profile.kinematics = KINEMATICS_CARTESIAN;
+			else if (type == "corexy")
+				profile.kinematics = KINEMATICS_COREXY;
+			else if (type == "delta")
+				profile.kinematics = KINEMATICS_DELTA;
+			else
+			{
+				std::cerr << filename << ":" << lineNumber << ": unknown kinematics " << type << std::endl;
+				return false;
+			}
+		}
+		else if (key == "max_motor_velocity")
+		{
+			positive = &profile.maxMotorVelocity.x;
+			expected = 4;
+			read = readFloats(value, &profile.maxMotorVelocity.x, 4);
+		}
+		else if (key == "delta_radius")
+		{
+			positive = &profile.deltaRadius;
+			read = readFloats(value, &profile.deltaRadius, 1);
+		}
+		else if (key == "delta_diagonal_rod")
+		{
+			positive = &profile.deltaDiagonalRod;
+			read = readFloats(value, &profile.deltaDiagonalRod, 1);
+		}
+		else if (key == "delta_segments_per_second")
+		{
+			positive = &profile.deltaSegmentsPerSecond;
+			read = readFloats(value, &profile.deltaSegmentsPerSecond, 1);
+		}
+		else if (key == "hotend_heater")
+		{
+			positive = &profile.hotend.power;
+			expected = 4;
+			read = readFloats(value, &profile.hotend.power, 4);
+		}
+		else if (key == "bed_heater")
+		{
+			positive = &profile.bed.power;
+			expected = 4;
+			read = readFloats(value, &profile.bed.power, 4);
+		}
+		else if (key == "tool_offset")
+		{
+			// Tool number followed by its offset
+			float values[4];
+			expected = 4;
+			read = readFloats(value, values, 4);
+			int tool = (int)values[0];
+			if (read == 4 && tool >= 0)
+			{
+				if ((int)profile.toolOffsets.size() <= tool)
+					profile.toolOffsets.resize(tool + 1, glm::vec3(0.0f));
+				profile.toolOffsets[tool] = glm::vec3(values[1], values[2], values[3]);
+			}
+		}
+		else if (key == "tool_change_time")
+		{
+			read = readFloats(value, &profile.toolChangeTime, 1);
+		}
+		else if (key == "ambient_temperature")
+		{
+			read = readFloats(value, &profile.ambientTemperature, 1);
+		}
+		else if (key == "temperature_tolerance")
+		{
+			read = readFloats(value, &profile.temperatureTolerance, 1);
+		}
+		else
+		{
+			std::cerr << filename << ":" << lineNumber << ": unknown profile key " << key << std::endl;
+			continue;
+		}
+
+		if (read != expected)
+		{
+			std::cerr << filename << ":" << lineNumber << ": expected " << expected << " value(s) for " << key << std::endl;
+			return false;
+		}
+		for (int i = 0; positive != NULL && i < read; i++)
+		{
+			if (!(positive[i] > 0.0f))
+			{
+				std::cerr << filename << ":" << lineNumber << ": " << key << " must be greater than 0" << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,96 @@
+#ifndef PRINTER_PROFILE_CLASS_H
+#define PRINTER_PROFILE_CLASS_H
+
+#include<glm/glm.hpp>
+#include<string>
+#include<vector>
+
+// How the motors move the head
+enum KinematicsType
+{
+	KINEMATICS_CARTESIAN, // One motor per axis
+	KINEMATICS_COREXY,    // Two belts share the bed plane axes X and Z
+	KINEMATICS_DELTA      // Three carriages on vertical towers with diagonal rods
+};
+
+// Lumped model of one heater: a single heat capacity driven by the heater and losing heat to the room
+struct HeaterModel
+{
+	// Heater power in W
+	float power;
+	// Heat capacity of the heated block in J/K
+	float capacity;
+	// Heat lost to the room per kelvin above ambient in W/K
+	float loss;
+	// Proportional band of the controller in K. The controller also feeds forward the power
+	// that holds the target, which is where the integral term of a tuned PID settles.
+	float band;
+};
+
+// Machine description shared by the viewer and the batch simulator.
+// Axes follow the viewer: X and Z span the bed, Y is the build height.
+// Per-axis limits are stored as (X, Y, Z, E).
+struct PrinterProfile
+{
+	std::string name = "default";
+
+	// Build volume, moves outside of it are clamped and counted
+	glm::vec3 bedMin = glm::vec3(-5.0f, 0.0f, -5.0f);
+	glm::vec3 bedMax = glm::vec3(5.0f, 2.0f, 5.0f);
+
+	// Maximum speed of every axis in units/s
+	glm::vec4 maxVelocity = glm::vec4(200.0f, 12.0f, 200.0f, 50.0f);
+	// Maximum acceleration of every axis in units/s^2
+	glm::vec4 maxAcceleration = glm::vec4(1500.0f, 100.0f, 1500.0f, 5000.0f);
+	// Instantaneous speed change allowed at a corner in units/s
+	glm::vec4 maxJerk = glm::vec4(10.0f, 0.4f, 10.0f, 5.0f);
+
+	// Feedrate used until the program sets one with F, in units/s
+	float defaultFeedrate = 25.0f;
+	// Diameter of the filament fed into the extruder
+	float filamentDiameter = 1.75f;
+	// Most plastic the hotend can melt in mm^3/s
+	float maxVolumetricFlow = 15.0f;
+	// Bead drawn where the program does not size one: moves of programs without E words, and layers
+	// that do not rise over the layer before
+	float lineWidth = 0.4f;
+	float layerHeight = 0.2f;
+
+	// Full motor steps per unit of travel and the driver's microstepping, per motor
+	glm::vec4 fullStepsPerUnit = glm::vec4(5.0f, 25.0f, 5.0f, 5.8f);
+	glm::vec4 microsteps = glm::vec4(16.0f, 16.0f, 16.0f, 16.0f);
+	// Step pulses per second the controller can generate over all motors together
+	float maxStepRate = 40000.0f;
+
+	glm::vec4 stepsPerUnit() const { return fullStepsPerUnit * microsteps; }
+
+	KinematicsType kinematics = KINEMATICS_CARTESIAN;
+	// Fastest every motor may turn, in units of motor travel per second.
+	// The lanes are the three motors of the kinematics and E.
+	glm::vec4 maxMotorVelocity = glm::vec4(200.0f, 12.0f, 200.0f, 50.0f);
+	// Distance from the center of the bed to every delta tower
+	float deltaRadius = 100.0f;
+	// Length of the delta diagonal rods
+	float deltaDiagonalRod = 215.0f;
+	// Delta moves are split into this many straight pieces per second of the requested feedrate
+	float deltaSegmentsPerSecond = 200.0f;
+
+	// Heaters for M104/M109 and M140/M190
+	HeaterModel hotend = { 40.0f, 12.0f, 0.15f, 10.0f };
+	HeaterModel bed = { 220.0f, 900.0f, 1.6f, 5.0f };
+	float ambientTemperature = 25.0f;
+	// M109 and M190 return once the heater is at most this far below its target
+	float temperatureTolerance = 1.0f;
+
+	// Nozzle offset of every tool from tool 0, tools without an entry have none
+	std::vector<glm::vec3> toolOffsets;
+	// Seconds a T command takes to park one tool and pick up the next
+	float toolChangeTime = 5.0f;
+
+	glm::vec3 toolOffset(int tool) const { return tool >= 0 && tool < (int)toolOffsets.size() ? toolOffsets[tool] : glm::vec3(0.0f); }
+};
+
+// Reads "key = value" lines into the profile, unknown keys are reported and skipped
+bool loadPrinterProfile(const char* filename, PrinterProfile& profile);
+
+#endif
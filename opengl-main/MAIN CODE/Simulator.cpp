@@ -0,0 +1,313 @@
+#include"Simulator.h"
+
+#include<algorithm>
+#include<cstdio>
+#include<iomanip>
+
+// Parses, plans and estimates a G-code program, then runs the analyses in job.options
+void simulateGcode(const std::string& gcode, const PrinterProfile& profile, SimulationJob& job)
+{
+	GcodeParser parser(profile);
+	job.toolpath.clear();
+	job.checkpoints.clear();
+	job.resumed = false;
+	if (job.options.checkpoints)
+		parseWithCheckpoints(parser, gcode.c_str(), gcode.size(), job.toolpath, job.checkpoints);
+	else
+		parser.parse(gcode, job.toolpath);
+	finishSimulation(parser, profile, job);
+}
+
+// Same as simulateGcode for a file on disk, returns false if it cannot be read
+bool simulateFile(const char* filename, const PrinterProfile& profile, SimulationJob& job)
+{
+	std::string gcode;
+	if (!readTextFile(filename, gcode))
+		return false;
+	simulateGcode(gcode, profile, job);
+	return true;
+}
+
+// Simulates the program from a checkpoint on, featureNames are the names found before it
+static void resumeAt(const std::string& gcode, const PrinterProfile& profile, const Checkpoint& checkpoint,
+	const std::vector<std::string>& featureNames, SimulationJob& resumed)
+{
+	// The restarted machine begins at rest from the checkpoint's position with its modal state
+	GcodeParser parser(profile);
+	parser.restoreState(checkpoint.parser);
+	resumed.toolpath.clear();
+	resumed.checkpoints.clear();
+	// The restored feature index refers to the names found before the layer
+	resumed.toolpath.featureNames = featureNames;
+	// The heaters were off, the restart waits for the temperatures the program had at the layer.
+	// Both heaters are switched on first like M140/M104, then waited for like M190/M109.
+	const ParserState& state = checkpoint.parser;
+	HeaterCommand reheat;
+	reheat.move = 0;
+	reheat.line = state.lineNumber;
+	for (bool wait : { false, true })
+	{
+		reheat.wait = wait;
+		if (state.bedTemperature > 0.0f)
+		{
+			reheat.heater = HEATER_BED;
+			reheat.target = state.bedTemperature;
+			resumed.toolpath.heaterCommands.push_back(reheat);
+		}
+		if (state.hotendTemperature > 0.0f)
+		{
+			reheat.heater = HEATER_HOTEND;
+			reheat.target = state.hotendTemperature;
+			resumed.toolpath.heaterCommands.push_back(reheat);
+		}
+	}
+	parser.parse(gcode.c_str() + checkpoint.offset, gcode.size() - checkpoint.offset, resumed.toolpath);
+	resumed.resumed = true;
+	resumed.resumePoint = checkpoint;
+	finishSimulation(parser, profile, resumed);
+}
+
+// Simulates the rest of an already simulated program as if the printer restarted at the start of layer
+bool resumeFromLayer(const std::string& gcode, const PrinterProfile& profile, const SimulationJob& full, size_t layer, SimulationJob& resumed)
+{
+	const Checkpoint* checkpoint = full.checkpoints.atLayer(layer);
+	if (checkpoint == NULL)
+		return false;
+	resumeAt(gcode, profile, *checkpoint, full.toolpath.featureNames, resumed);
+	return true;
+}
+
+// Simulates a program as if the printer restarted at the start of layer, without simulating it from the start
+bool simulateFromLayer(const std::string& gcode, const PrinterProfile& profile, size_t layer, SimulationJob& resumed)
+{
+	// Only a parse that stops at the layer runs over the layers before, it finds the checkpoint.
+	// Nothing is planned there, so the checkpoint carries no elapsed time.
+	GcodeParser parser(profile);
+	Toolpath toolpath;
+	CheckpointTable checkpoints;
+	parseWithCheckpoints(parser, gcode.c_str(), gcode.size(), toolpath, checkpoints, layer);
+	const Checkpoint* checkpoint = checkpoints.atLayer(layer);
+	if (checkpoint == NULL)
+		return false;
+	resumeAt(gcode, profile, *checkpoint, toolpath.featureNames, resumed);
+	return true;
+}
+
+// Runs everything after parsing: kinematics, planning within the motor limits, statistics and analyses
+void finishSimulation(const GcodeParser& parser, const PrinterProfile& profile, SimulationJob& job)
+{
+	// Every move is capped so the motor that works hardest stays within its limit,
+	// which matters most on delta and CoreXY machines where motors can outrun the head
+	job.kinematics = profile.kinematics;
+	buildMotorPath(job.toolpath, profile, job.motors);
+	std::vector<float> speedLimit;
+	motorSpeedLimits(job.toolpath, job.motors, profile, speedLimit, job.motorViolations);
+	planMotion(job.toolpath, profile, job.plan, &speedLimit);
+	timeMotorPath(job.plan, job.motors);
+	computeStats(parser, profile, job);
+	computeFlow(job.toolpath, job.plan, profile, job.flow);
+	computeFlowStats(job.toolpath, job.plan, job.flow, profile, job.flowStats);
+	if (job.options.limits)
+		checkLimits(job.toolpath, profile, job.limits, job.options.pool);
+
+	buildHeatingProgram(job.toolpath, job.plan, job.heating);
+	job.heatingResult = HeatingResult();
+	if (job.options.heating)
+	{
+		std::vector<HeatingResult> results;
+		simulateHeating({ &job.heating }, { &profile }, results);
+		job.heatingResult = results[0];
+		addHeating(job.heatingResult, job.stats);
+	}
+	timeCheckpoints(job.plan, job.checkpoints);
+	for (Checkpoint& checkpoint : job.checkpoints.checkpoints)
+	{
+		int line = checkpoint.parser.lineNumber + 1;
+		checkpoint.time += job.heatingResult.waitBeforeLine(job.heating, line);
+		for (size_t i = 0; i < job.toolpath.toolChanges.size() && job.toolpath.toolChanges[i].line < line; i++)
+			checkpoint.time += profile.toolChangeTime;
+	}
+
+	if (job.options.steps)
+	{
+		generateSteps(job.motors, job.plan, profile, job.steps);
+		computeStepStats(job.toolpath, job.steps, profile, job.stepStats);
+	}
+}
+
+// Fills the statistics from an already parsed and planned job
+void computeStats(const GcodeParser& parser, const PrinterProfile& profile, SimulationJob& job)
+{
+	const Toolpath& toolpath = job.toolpath;
+	SimulationStats& stats = job.stats;
+	stats = SimulationStats();
+
+	// Motion stops while one tool is parked and the next one picked up
+	stats.toolChanges = toolpath.toolChanges.size();
+	stats.toolChangeTime = stats.toolChanges * profile.toolChangeTime;
+	stats.printTime = job.plan.totalTime + stats.toolChangeTime;
+	stats.moveCount = toolpath.size();
+	stats.layerCount = toolpath.layerHeight.size();
+	stats.commandCounts = parser.commandCounts;
+	// The parser of a resumed job continues the line and bounds counts of the checkpoint,
+	// every statistic covers only the lines parsed after it like the moves and commands do
+	stats.lineCount = parser.lineNumber;
+	stats.outOfBoundsMoves = parser.outOfBoundsMoves;
+	if (job.resumed)
+	{
+		stats.lineCount -= job.resumePoint.parser.lineNumber;
+		stats.outOfBoundsMoves -= job.resumePoint.parser.outOfBoundsMoves;
+	}
+
+	glm::vec3 boundsMin = toolpath.origin;
+	glm::vec3 boundsMax = toolpath.origin;
+	// Net extruder travel, a prime after a retraction gives back what the retraction took
+	double filament = 0.0;
+	stats.toolMoves.assign(toolpath.toolCount, 0);
+	stats.toolFilament.assign(toolpath.toolCount, 0.0);
+	for (size_t i = 0; i < toolpath.size(); i++)
+	{
+		boundsMin = glm::min(boundsMin, toolpath.position(i));
+		boundsMax = glm::max(boundsMax, toolpath.position(i));
+		float extruded = toolpath.e[i] - toolpath.startEOf(i);
+		filament += extruded;
+		stats.toolMoves[toolpath.tool[i]]++;
+		stats.toolFilament[toolpath.tool[i]] += extruded;
+	}
+	for (size_t i = 0; i < job.motors.size(); i++)
+		stats.peakMotorVelocity = glm::max(stats.peakMotorVelocity, job.motors.peakVelocity[i]);
+	stats.filamentLength = std::max(0.0, filament);
+	float radius = profile.filamentDiameter * 0.5f;
+	stats.filamentVolume = stats.filamentLength * 3.14159265358979 * radius * radius;
+	stats.boundsMin = boundsMin;
+	stats.boundsMax = boundsMax;
+}
+
+// Adds the heater waits to the time estimate
+void addHeating(const HeatingResult& heating, SimulationStats& stats)
+{
+	stats.heatingTime = heating.totalWait;
+	stats.unreachableTemperatures = heating.unreachable;
+	stats.printTime += heating.totalWait;
+}
+
+// Quotes and escapes text for use as a JSON string
+std::string jsonString(const std::string& text)
+{
+	std::string escaped = "\"";
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", c);
+			escaped += code;
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	return escaped + "\"";
+}
+
+static void writeVec3(std::ostream& out, const glm::vec3& v)
+{
+	out << "[" << v.x << ", " << v.y << ", " << v.z << "]";
+}
+
+// Writes the statistics and the enabled analyses as one JSON object
+void writeJobJson(std::ostream& out, const std::string& source, const SimulationJob& job)
+{
+	const SimulationStats& stats = job.stats;
+	out << std::setprecision(9);
+	out << "{\"file\": " << jsonString(source);
+	out << ", \"time_s\": " << stats.printTime;
+	out << ", \"heating_s\": " << stats.heatingTime;
+	out << ", \"tool_change_s\": " << stats.toolChangeTime;
+	if (stats.unreachableTemperatures > 0)
+		out << ", \"unreachable_temperatures\": " << stats.unreachableTemperatures;
+	out << ", \"filament_mm\": " << stats.filamentLength;
+	out << ", \"filament_mm3\": " << stats.filamentVolume;
+	out << ", \"bounds\": {\"min\": ";
+	writeVec3(out, stats.boundsMin);
+	out << ", \"max\": ";
+	writeVec3(out, stats.boundsMax);
+	out << "}";
+	out << ", \"layers\": " << stats.layerCount;
+	out << ", \"moves\": " << stats.moveCount;
+	out << ", \"lines\": " << stats.lineCount;
+	out << ", \"out_of_bounds_moves\": " << stats.outOfBoundsMoves;
+	out << ", \"tool_changes\": " << stats.toolChanges;
+	out << ", \"tools\": [";
+	for (size_t tool = 0; tool < stats.toolMoves.size(); tool++)
+	{
+		out << (tool == 0 ? "" : ", ") << "{\"tool\": " << tool << ", \"moves\": " << stats.toolMoves[tool];
+		out << ", \"filament_mm\": " << stats.toolFilament[tool] << "}";
+	}
+	out << "]";
+	out << ", \"commands\": {";
+	bool first = true;
+	for (const auto& command : stats.commandCounts)
+	{
+		out << (first ? "" : ", ") << jsonString(command.first) << ": " << command.second;
+		first = false;
+	}
+	out << "}";
+
+	out << ", \"kinematics\": {\"peak_motor_velocity\": {";
+	for (int motor = 0; motor < 4; motor++)
+		out << (motor == 0 ? "" : ", ") << "\"" << motorName(job.kinematics, motor) << "\": " << stats.peakMotorVelocity[motor];
+	out << "}, \"pieces\": " << job.motors.pieces;
+	out << ", \"slowed_moves\": " << job.motorViolations.size();
+	out << ", \"slowed\": [";
+	// The list is capped, the count above has the full number
+	size_t listed = std::min<size_t>(job.motorViolations.size(), 100);
+	for (size_t i = 0; i < listed; i++)
+	{
+		const MotorSpeedViolation& violation = job.motorViolations[i];
+		out << (i == 0 ? "" : ", ") << "{\"line\": " << violation.line;
+		out << ", \"motor\": \"" << motorName(job.kinematics, violation.motor) << "\"";
+		out << ", \"requested\": " << violation.velocity << ", \"limit\": " << violation.limit << "}";
+	}
+	out << "]}";
+
+	out << ", \"flow\": ";
+	writeFlowStatsJson(out, job.flowStats);
+	if (job.options.limits)
+	{
+		out << ", \"limits\": ";
+		writeLimitReportJson(out, job.limits);
+	}
+
+	if (job.options.checkpoints && !job.resumed)
+		out << ", \"checkpoints\": " << job.checkpoints.size();
+	if (job.resumed)
+	{
+		const Checkpoint& checkpoint = job.resumePoint;
+		const ParserState& state = checkpoint.parser;
+		out << ", \"resume\": {\"layer\": " << checkpoint.layers;
+		out << ", \"line\": " << state.lineNumber + 1;
+		out << ", \"position\": ";
+		writeVec3(out, state.position + state.positionOffset);
+		out << ", \"e\": " << state.e + state.eOffset;
+		out << ", \"feedrate\": " << state.feedrate;
+		out << ", \"tool\": " << state.tool;
+		out << ", \"absolute_positioning\": " << (state.absolutePositioning ? "true" : "false");
+		out << ", \"absolute_extrusion\": " << (state.absoluteExtrusion ? "true" : "false");
+		out << ", \"hotend_temperature\": " << state.hotendTemperature;
+		out << ", \"bed_temperature\": " << state.bedTemperature << "}";
+	}
+
+	if (job.options.steps)
+	{
+		out << ", \"steps\": ";
+		writeStepStatsJson(out, job.stepStats, job.kinematics);
+	}
+	out << "}";
+}
@@ -0,0 +1,112 @@
+#ifndef SIMULATOR_CLASS_H
+#define SIMULATOR_CLASS_H
+
+#include<glm/glm.hpp>
+#include<map>
+#include<ostream>
+#include<string>
+#include<vector>
+
+#include"Checkpoint.h"
+#include"Flow.h"
+#include"Gcode.h"
+#include"Kinematics.h"
+#include"Limits.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+#include"Stepper.h"
+#include"Thermal.h"
+
+// Summary of a simulated job, the same numbers the viewer and the batch simulator report
+struct SimulationStats
+{
+	// Estimated duration in seconds, heater waits included
+	double printTime = 0.0;
+	// Time spent in M109/M190 waiting for heaters
+	double heatingTime = 0.0;
+	// Time spent changing tools
+	double toolChangeTime = 0.0;
+	size_t toolChanges = 0;
+	size_t unreachableTemperatures = 0;
+	// Filament pushed into the extruder, retractions that are primed again do not count twice
+	double filamentLength = 0.0;
+	double filamentVolume = 0.0;
+	// Box around every position the head visits
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	size_t layerCount = 0;
+	size_t moveCount = 0;
+	size_t lineCount = 0;
+	size_t outOfBoundsMoves = 0;
+	std::map<std::string, size_t> commandCounts;
+	// Moves and net filament of every tool
+	std::vector<size_t> toolMoves;
+	std::vector<double> toolFilament;
+	// Fastest every motor turns over the whole job, lanes as in MotorPath
+	glm::vec4 peakMotorVelocity = glm::vec4(0.0f);
+};
+
+// Optional analyses run after planning
+struct SimulationOptions
+{
+	// Step generation with step-rate statistics
+	bool steps = false;
+	// Checkpoints for rewinding and restarting from a layer
+	bool checkpoints = false;
+	// Heater model for the waits of M109/M190, farms turn it off and run it for all jobs at once
+	bool heating = true;
+	// Per-axis velocity, acceleration and jerk check of the requested moves
+	bool limits = false;
+	// Pool the parallel analyses run on, NULL runs them on the calling thread
+	ThreadPool* pool = NULL;
+};
+
+// Everything produced for one G-code program
+struct SimulationJob
+{
+	SimulationOptions options;
+	KinematicsType kinematics = KINEMATICS_CARTESIAN;
+	Toolpath toolpath;
+	MotorPath motors;
+	// Moves the motor limits slowed down below their requested feedrate
+	std::vector<MotorSpeedViolation> motorViolations;
+	MotionPlan plan;
+	SimulationStats stats;
+	// Volumetric flow of every move in mm^3/s
+	std::vector<float> flow;
+	FlowStats flowStats;
+	LimitReport limits;
+	StepPlan steps;
+	StepStats stepStats;
+	HeatingProgram heating;
+	HeatingResult heatingResult;
+	CheckpointTable checkpoints;
+	// Set when the job restarts part way through a program, resumePoint is where
+	bool resumed = false;
+	Checkpoint resumePoint;
+};
+
+// Parses, plans and estimates a G-code program, then runs the analyses in job.options
+void simulateGcode(const std::string& gcode, const PrinterProfile& profile, SimulationJob& job);
+// Same as simulateGcode for a file on disk, returns false if it cannot be read
+bool simulateFile(const char* filename, const PrinterProfile& profile, SimulationJob& job);
+// Simulates the rest of an already simulated program as if the printer restarted at the start of layer.
+// Only the lines from the layer's checkpoint on are parsed again. Returns false if there is no such layer.
+bool resumeFromLayer(const std::string& gcode, const PrinterProfile& profile, const SimulationJob& full, size_t layer, SimulationJob& resumed);
+// Same as resumeFromLayer for a program that was not simulated yet. The layers before are only parsed up to
+// the layer's checkpoint, so this costs about as much as simulating the layers from it on.
+bool simulateFromLayer(const std::string& gcode, const PrinterProfile& profile, size_t layer, SimulationJob& resumed);
+// Runs everything after parsing: kinematics, planning within the motor limits, statistics and analyses
+void finishSimulation(const GcodeParser& parser, const PrinterProfile& profile, SimulationJob& job);
+// Fills the statistics from an already parsed and planned job
+void computeStats(const GcodeParser& parser, const PrinterProfile& profile, SimulationJob& job);
+
+// Adds the heater waits to the time estimate
+void addHeating(const HeatingResult& heating, SimulationStats& stats);
+
+// Quotes and escapes text for use as a JSON string
+std::string jsonString(const std::string& text);
+// Writes the statistics and the enabled analyses as one JSON object
+void writeJobJson(std::ostream& out, const std::string& source, const SimulationJob& job);
+
+#endif
@@ -0,0 +1,141 @@
+#include"Stepper.h"
+
+#include<algorithm>
+#include<cmath>
+#include<iomanip>
+
+// Converts the planned moves to microsteps, rounding errors carry over to the next move
+void generateSteps(const MotorPath& motors, const MotionPlan& plan, const PrinterProfile& profile, StepPlan& steps)
+{
+	size_t count = motors.size();
+	steps.steps.resize(count);
+	steps.peakRate.resize(count);
+
+	// All four motors are handled as one vector so every move costs a few 4-wide operations.
+	// Positions are rounded in absolute steps, which keeps the Bresenham remainder of one
+	// move as the starting error of the next one instead of accumulating drift.
+	const glm::vec4 stepsPerUnit = profile.stepsPerUnit();
+	glm::ivec4 previous = glm::ivec4(glm::round(motors.origin * stepsPerUnit));
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::ivec4 current = glm::ivec4(glm::round(motors.end[i] * stepsPerUnit));
+		steps.steps[i] = current - previous;
+		previous = current;
+
+		// The gain of every motor scales the cruise speed to its fastest step rate in the move
+		steps.peakRate[i] = motors.gain[i] * plan.cruiseSpeed[i] * stepsPerUnit;
+	}
+}
+
+// Histogram bin of a step rate
+static int rateBin(float rate)
+{
+	if (rate < StepStats::histogramBase * 2.0f)
+		return 0;
+	int bin = (int)std::floor(std::log2(rate / StepStats::histogramBase));
+	return std::min(bin, StepStats::histogramBins - 1);
+}
+
+// Peak rates, histograms and the moves above profile.maxStepRate
+void computeStepStats(const Toolpath& toolpath, const StepPlan& steps, const PrinterProfile& profile, StepStats& stats)
+{
+	stats = StepStats();
+	for (size_t i = 0; i < steps.size(); i++)
+	{
+		const glm::vec4& rate = steps.peakRate[i];
+		glm::ivec4 moved = glm::abs(steps.steps[i]);
+		float total = rate.x + rate.y + rate.z + rate.w;
+		if (total == 0.0f)
+			continue;
+
+		stats.peakRate = glm::max(stats.peakRate, rate);
+		stats.peakTotalRate = std::max(stats.peakTotalRate, total);
+		for (int motor = 0; motor < 4; motor++)
+		{
+			stats.totalSteps[motor] += moved[motor];
+			if (moved[motor] > 0)
+				stats.histogram[motor][rateBin(rate[motor])]++;
+		}
+		stats.histogram[4][rateBin(total)]++;
+
+		if (total > profile.maxStepRate)
+		{
+			StepRateViolation violation;
+			violation.move = i;
+			violation.line = toolpath.line[i];
+			violation.rate = total;
+			stats.violations.push_back(violation);
+		}
+	}
+}
+
+// Appends the pulses of one move, spread over the move Bresenham style along the trapezoid
+void generateStepEvents(const MotionPlan& plan, const StepPlan& steps, size_t move, std::vector<StepEvent>& events)
+{
+	glm::ivec4 delta = steps.steps[move];
+	glm::ivec4 moved = glm::abs(delta);
+	int major = std::max(std::max(moved.x, moved.y), std::max(moved.z, moved.w));
+	if (major == 0 || plan.length[move] == 0.0f)
+		return;
+
+	// The motor with the most steps sets the pace, the others step when their error overflows
+	glm::ivec4 error = glm::ivec4(major / 2);
+	double start = plan.startTime(move);
+	for (int n = 1; n <= major; n++)
+	{
+		float distance = plan.length[move] * n / major;
+		double time = start + plan.timeAtDistance(move, distance);
+		error += moved;
+		for (int motor = 0; motor < 4; motor++)
+		{
+			if (error[motor] < major)
+				continue;
+			error[motor] -= major;
+			StepEvent event;
+			event.time = time;
+			event.motor = (unsigned char)motor;
+			event.direction = delta[motor] > 0 ? 1 : -1;
+			events.push_back(event);
+		}
+	}
+}
+
+// Writes the step statistics as one JSON object, motors are named after the kinematics
+void writeStepStatsJson(std::ostream& out, const StepStats& stats, KinematicsType kinematics)
+{
+	const char* names[5];
+	for (int motor = 0; motor < 4; motor++)
+		names[motor] = motorName(kinematics, motor);
+	names[4] = "total";
+	out << std::setprecision(9);
+	out << "{\"peak_rate\": {";
+	for (int motor = 0; motor < 4; motor++)
+		out << "\"" << names[motor] << "\": " << stats.peakRate[motor] << ", ";
+	out << "\"total\": " << stats.peakTotalRate << "}";
+	out << ", \"total_steps\": {";
+	for (int motor = 0; motor < 4; motor++)
+		out << (motor == 0 ? "" : ", ") << "\"" << names[motor] << "\": " << stats.totalSteps[motor];
+	out << "}";
+
+	out << ", \"histogram_base\": " << StepStats::histogramBase;
+	out << ", \"histogram\": {";
+	for (int h = 0; h < 5; h++)
+	{
+		out << (h == 0 ? "" : ", ") << "\"" << names[h] << "\": [";
+		for (int bin = 0; bin < StepStats::histogramBins; bin++)
+			out << (bin == 0 ? "" : ", ") << stats.histogram[h][bin];
+		out << "]";
+	}
+	out << "}";
+
+	out << ", \"over_budget_moves\": " << stats.violations.size();
+	out << ", \"over_budget\": [";
+	// The list is capped, the count above has the full number
+	size_t listed = std::min<size_t>(stats.violations.size(), 100);
+	for (size_t i = 0; i < listed; i++)
+	{
+		const StepRateViolation& violation = stats.violations[i];
+		out << (i == 0 ? "" : ", ") << "{\"line\": " << violation.line << ", \"rate\": " << violation.rate << "}";
+	}
+	out << "]}";
+}
@@ -0,0 +1,68 @@
+#ifndef STEPPER_CLASS_H
+#define STEPPER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<ostream>
+#include<vector>
+
+#include"Gcode.h"
+#include"Kinematics.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+
+// Step counts of every move, the four lanes are the motors of the kinematics and E
+struct StepPlan
+{
+	// Signed microsteps every motor takes during the move
+	std::vector<glm::ivec4> steps;
+	// Step rate of every motor while the move cruises, in steps/s
+	std::vector<glm::vec4> peakRate;
+
+	size_t size() const { return steps.size(); }
+};
+
+// A move whose combined step rate is above the MCU budget
+struct StepRateViolation
+{
+	size_t move;
+	int line;
+	float rate;
+};
+
+struct StepStats
+{
+	// Bin b of a histogram counts moves with rates in [histogramBase * 2^b, histogramBase * 2^(b+1)),
+	// the first and last bins also take everything below and above
+	static const int histogramBins = 16;
+	static constexpr float histogramBase = 64.0f;
+
+	// Highest rate of every motor and of all motors together
+	glm::vec4 peakRate = glm::vec4(0.0f);
+	float peakTotalRate = 0.0f;
+	// Microsteps every motor takes over the whole job
+	long long totalSteps[4] = { 0, 0, 0, 0 };
+	// Moves per rate bin, one histogram per motor and one for the combined rate
+	size_t histogram[5][histogramBins] = {};
+	std::vector<StepRateViolation> violations;
+};
+
+// A single step pulse
+struct StepEvent
+{
+	// Seconds since the start of the job
+	double time;
+	unsigned char motor;
+	signed char direction;
+};
+
+// Converts the planned moves to microsteps, rounding errors carry over to the next move
+void generateSteps(const MotorPath& motors, const MotionPlan& plan, const PrinterProfile& profile, StepPlan& steps);
+// Peak rates, histograms and the moves above profile.maxStepRate
+void computeStepStats(const Toolpath& toolpath, const StepPlan& steps, const PrinterProfile& profile, StepStats& stats);
+// Appends the pulses of one move, spread over the move Bresenham style along the trapezoid
+void generateStepEvents(const MotionPlan& plan, const StepPlan& steps, size_t move, std::vector<StepEvent>& events);
+
+// Writes the step statistics as one JSON object, motors are named after the kinematics
+void writeStepStatsJson(std::ostream& out, const StepStats& stats, KinematicsType kinematics);
+
+#endif
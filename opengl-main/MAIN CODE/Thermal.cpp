@@ -0,0 +1,181 @@
+#include"Thermal.h"
+
+#include<algorithm>
+
+// Integration step of the heater model in seconds, well below the closed loop time constants
+static const float timeStep = 0.1f;
+// Open loop time constants after which a heater counts as settled
+static const float settleTimeConstants = 10.0f;
+
+// Adds a lane at room temperature with the heater off
+void HeaterBank::add(const HeaterModel& model, float ambientTemperature)
+{
+	temperature.push_back(ambientTemperature);
+	target.push_back(0.0f);
+	power.push_back(model.power);
+	capacity.push_back(model.capacity);
+	loss.push_back(model.loss);
+	band.push_back(model.band);
+	ambient.push_back(ambientTemperature);
+}
+
+// Advances every lane by its own time step, a step of zero leaves the lane alone
+void stepHeaters(HeaterBank& bank, const float* dt)
+{
+	size_t count = bank.size();
+	float* temperature = bank.temperature.data();
+	const float* target = bank.target.data();
+	const float* power = bank.power.data();
+	const float* capacity = bank.capacity.data();
+	const float* loss = bank.loss.data();
+	const float* band = bank.band.data();
+	const float* ambient = bank.ambient.data();
+	for (size_t i = 0; i < count; i++)
+	{
+		// Feed forward of the holding power plus a proportional term, a target of 0 turns the heater off
+		float holding = loss[i] * (target[i] - ambient[i]) / power[i];
+		float duty = std::min(std::max(holding + (target[i] - temperature[i]) / band[i], 0.0f), 1.0f);
+		duty = target[i] > 0.0f ? duty : 0.0f;
+		float flow = power[i] * duty - loss[i] * (temperature[i] - ambient[i]);
+		temperature[i] += dt[i] * flow / capacity[i];
+	}
+}
+
+// Waits that happen before the given source line
+double HeatingResult::waitBeforeLine(const HeatingProgram& program, int line) const
+{
+	double total = 0.0;
+	for (size_t i = 0; i < program.size() && program.commands[i].line < line; i++)
+		total += wait[i];
+	return total;
+}
+
+// Extracts the temperature commands of a planned job
+void buildHeatingProgram(const Toolpath& toolpath, const MotionPlan& plan, HeatingProgram& program)
+{
+	program.commands = toolpath.heaterCommands;
+	program.motionBefore.resize(program.size());
+	double previous = 0.0;
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		size_t move = program.commands[i].move;
+		double time = move < plan.size() ? plan.startTime(move) : plan.totalTime;
+		program.motionBefore[i] = (float)(time - previous);
+		previous = time;
+	}
+}
+
+// Steps the lanes until every remaining time is used up
+static void advanceHeaters(HeaterBank& bank, std::vector<float>& remaining, std::vector<float>& dt)
+{
+	float longest = *std::max_element(remaining.begin(), remaining.end());
+	int steps = (int)std::ceil(longest / timeStep);
+	for (int step = 0; step < steps; step++)
+	{
+		for (size_t i = 0; i < remaining.size(); i++)
+		{
+			dt[i] = std::min(remaining[i], timeStep);
+			remaining[i] -= dt[i];
+		}
+		stepHeaters(bank, dt.data());
+	}
+}
+
+// Runs the heater model of all programs in lockstep, a hotend and a bed lane per program
+void simulateHeating(const std::vector<const HeatingProgram*>& programs, const std::vector<const PrinterProfile*>& profiles,
+	std::vector<HeatingResult>& results)
+{
+	size_t count = programs.size();
+	results.assign(count, HeatingResult());
+	if (count == 0)
+		return;
+
+	HeaterBank bank;
+	size_t commands = 0;
+	for (size_t p = 0; p < count; p++)
+	{
+		bank.add(profiles[p]->hotend, profiles[p]->ambientTemperature);
+		bank.add(profiles[p]->bed, profiles[p]->ambientTemperature);
+		results[p].wait.assign(programs[p]->size(), 0.0f);
+		commands = std::max(commands, programs[p]->size());
+	}
+
+	// After this long without a new command a heater has settled, longer stretches of motion are skipped
+	std::vector<float> settle(bank.size());
+	for (size_t i = 0; i < bank.size(); i++)
+		settle[i] = settleTimeConstants * bank.capacity[i] / bank.loss[i];
+
+	std::vector<float> remaining(bank.size());
+	std::vector<float> dt(bank.size());
+	std::vector<char> waiting(count);
+	std::vector<float> waited(count);
+	for (size_t k = 0; k < commands; k++)
+	{
+		// Motion up to the k-th command of every program
+		for (size_t p = 0; p < count; p++)
+		{
+			float motion = k < programs[p]->size() ? programs[p]->motionBefore[k] : 0.0f;
+			remaining[2 * p] = std::min(motion, settle[2 * p]);
+			remaining[2 * p + 1] = std::min(motion, settle[2 * p + 1]);
+		}
+		advanceHeaters(bank, remaining, dt);
+
+		// The command itself, waits keep both heaters of the printer running until the target is reached.
+		// Like M109 S and M190 S they only wait for heating up, a heater above its target or turned off goes on.
+		bool anyWaiting = false;
+		for (size_t p = 0; p < count; p++)
+		{
+			waiting[p] = 0;
+			waited[p] = 0.0f;
+			if (k >= programs[p]->size())
+				continue;
+			const HeaterCommand& command = programs[p]->commands[k];
+			size_t lane = 2 * p + command.heater;
+			bank.target[lane] = command.target;
+			if (command.wait && command.target > 0.0f
+				&& bank.temperature[lane] < command.target - profiles[p]->temperatureTolerance)
+			{
+				waiting[p] = 1;
+				anyWaiting = true;
+			}
+		}
+		while (anyWaiting)
+		{
+			for (size_t p = 0; p < count; p++)
+			{
+				dt[2 * p] = waiting[p] ? timeStep : 0.0f;
+				dt[2 * p + 1] = dt[2 * p];
+			}
+			stepHeaters(bank, dt.data());
+
+			anyWaiting = false;
+			for (size_t p = 0; p < count; p++)
+			{
+				if (!waiting[p])
+					continue;
+				waited[p] += timeStep;
+				const HeaterCommand& command = programs[p]->commands[k];
+				size_t lane = 2 * p + command.heater;
+				if (bank.temperature[lane] >= command.target - profiles[p]->temperatureTolerance)
+				{
+					waiting[p] = 0;
+				}
+				else if (waited[p] >= settle[lane])
+				{
+					// The heater settled somewhere else, the printer would hang here
+					waiting[p] = 0;
+					results[p].unreachable++;
+				}
+				anyWaiting = anyWaiting || waiting[p];
+			}
+		}
+
+		for (size_t p = 0; p < count; p++)
+		{
+			if (k >= programs[p]->size())
+				continue;
+			results[p].wait[k] = waited[p];
+			results[p].totalWait += waited[p];
+		}
+	}
+}
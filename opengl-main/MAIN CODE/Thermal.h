@@ -0,0 +1,60 @@
+#ifndef THERMAL_CLASS_H
+#define THERMAL_CLASS_H
+
+#include<vector>
+
+#include"Gcode.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+
+// Heaters of many printers stored column by column, one lane per heater
+struct HeaterBank
+{
+	std::vector<float> temperature;
+	std::vector<float> target;
+	std::vector<float> power;
+	std::vector<float> capacity;
+	std::vector<float> loss;
+	std::vector<float> band;
+	std::vector<float> ambient;
+
+	size_t size() const { return temperature.size(); }
+	// Adds a lane at room temperature with the heater off
+	void add(const HeaterModel& model, float ambientTemperature);
+};
+
+// Advances every lane by its own time step, a step of zero leaves the lane alone.
+// The loop is branch free so the compiler can run it several lanes at a time.
+void stepHeaters(HeaterBank& bank, const float* dt);
+
+// Temperature commands of a job with the motion time in between, all the heater model needs
+struct HeatingProgram
+{
+	std::vector<HeaterCommand> commands;
+	// Seconds of motion between the previous command (or the job start) and every command
+	std::vector<float> motionBefore;
+
+	size_t size() const { return commands.size(); }
+};
+
+// Time spent waiting for heaters
+struct HeatingResult
+{
+	// Seconds every command held the program, zero for commands that do not wait
+	std::vector<float> wait;
+	double totalWait = 0.0;
+	// Waits given up on because the heater cannot reach its target
+	size_t unreachable = 0;
+
+	// Waits that happen before the given source line
+	double waitBeforeLine(const HeatingProgram& program, int line) const;
+};
+
+// Extracts the temperature commands of a planned job
+void buildHeatingProgram(const Toolpath& toolpath, const MotionPlan& plan, HeatingProgram& program);
+// Runs the heater model of all programs in lockstep, a hotend and a bed lane per program,
+// and fills one result per program
+void simulateHeating(const std::vector<const HeatingProgram*>& programs, const std::vector<const PrinterProfile*>& profiles,
+	std::vector<HeatingResult>& results);
+
+#endif
@@ -0,0 +1,175 @@
+#include"ThreadPool.h"
+
+#include<algorithm>
+
+// Worker index of the current thread, -1 for threads outside of any pool
+static thread_local int workerIndex = -1;
+
+// Starts threadCount workers, 0 uses one per hardware thread
+ThreadPool::ThreadPool(unsigned threadCount)
+	: pending(0), queued(0), nextWorker(0)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned i = 0; i < threadCount; i++)
+		workers.push_back(std::unique_ptr<Worker>(new Worker()));
+	for (unsigned i = 0; i < threadCount; i++)
+		threads.push_back(std::thread(&ThreadPool::run, this, i));
+}
+
+// Finishes the queued tasks and joins the workers
+ThreadPool::~ThreadPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+int ThreadPool::currentWorker()
+{
+	return workerIndex;
+}
+
+// Queues a task, tasks submitted from a worker go to that worker's deque
+void ThreadPool::submit(std::function<void()> task)
+{
+	unsigned index = workerIndex >= 0 && (unsigned)workerIndex < workers.size()
+		? (unsigned)workerIndex
+		: nextWorker++ % (unsigned)workers.size();
+
+	pending++;
+	{
+		std::lock_guard<std::mutex> lock(workers[index]->mutex);
+		workers[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		queued++;
+	}
+	wakeCondition.notify_one();
+}
+
+// Pops the newest task of the own deque, or steals the oldest one of another worker
+bool ThreadPool::takeTask(unsigned index, std::function<void()>& task)
+{
+	unsigned count = (unsigned)workers.size();
+	if (index < count)
+	{
+		Worker& own = *workers[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			queued--;
+			return true;
+		}
+	}
+	for (unsigned offset = 1; offset <= count; offset++)
+	{
+		Worker& victim = *workers[(index + offset) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Runs one queued task on behalf of worker index, returns false when there was none
+bool ThreadPool::runTask(unsigned index)
+{
+	std::function<void()> task;
+	if (!takeTask(index, task))
+		return false;
+	task();
+	if (--pending == 0)
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		idleCondition.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::run(unsigned index)
+{
+	workerIndex = (int)index;
+	while (true)
+	{
+		if (runTask(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		wakeCondition.wait(lock, [this] { return stopping || queued > 0; });
+		if (stopping && queued == 0)
+			return;
+	}
+}
+
+// Blocks until every submitted task has finished
+void ThreadPool::wait()
+{
+	// A worker waiting on the pool keeps running tasks instead of blocking one of the threads
+	if (workerIndex >= 0)
+	{
+		while (pending > 0)
+		{
+			if (!runTask((unsigned)workerIndex))
+				std::this_thread::yield();
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	idleCondition.wait(lock, [this] { return pending == 0; });
+}
+
+// Runs body over [0, count) split into ranges of about grain items and waits for them
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+{
+	if (count == 0)
+		return;
+	grain = std::max<size_t>(1, grain);
+	if (count <= grain || workers.size() == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	std::atomic<size_t> remaining((count + grain - 1) / grain);
+	std::mutex doneMutex;
+	std::condition_variable doneCondition;
+	for (size_t begin = 0; begin < count; begin += grain)
+	{
+		size_t end = std::min(count, begin + grain);
+		submit([&, begin, end]
+		{
+			body(begin, end);
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--remaining == 0)
+				doneCondition.notify_all();
+		});
+	}
+
+	// The calling thread works on the ranges too, then waits for the ones still running
+	unsigned helper = workerIndex >= 0 ? (unsigned)workerIndex : (unsigned)workers.size();
+	while (remaining > 0)
+	{
+		if (runTask(helper))
+			continue;
+		std::unique_lock<std::mutex> lock(doneMutex);
+		doneCondition.wait_for(lock, std::chrono::milliseconds(1), [&] { return remaining == 0; });
+	}
+	// The last range may still hold the lock it signalled with
+	std::lock_guard<std::mutex> lock(doneMutex);
+}
@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_CLASS_H
+#define THREAD_POOL_CLASS_H
+
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+// Work-stealing thread pool. Every worker owns a deque, takes its newest task first
+// and steals the oldest task of another worker when its own deque runs dry.
+class ThreadPool
+{
+public:
+	// Starts threadCount workers, 0 uses one per hardware thread
+	ThreadPool(unsigned threadCount = 0);
+	// Finishes the queued tasks and joins the workers
+	~ThreadPool();
+
+	// Queues a task, tasks submitted from a worker go to that worker's deque
+	void submit(std::function<void()> task);
+	// Blocks until every submitted task has finished
+	void wait();
+	// Runs body over [0, count) split into ranges of about grain items and waits for them
+	void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+	unsigned size() const { return (unsigned)threads.size(); }
+	// Index of the worker running the calling code, -1 outside of the pool
+	static int currentWorker();
+
+private:
+	struct Worker
+	{
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable idleCondition;
+	// Tasks queued or running
+	std::atomic<size_t> pending;
+	// Tasks queued but not picked up yet
+	std::atomic<size_t> queued;
+	std::atomic<unsigned> nextWorker;
+	bool stopping = false;
+
+	void run(unsigned index);
+	bool runTask(unsigned index);
+	bool takeTask(unsigned index, std::function<void()>& task);
+};
+
+#endif
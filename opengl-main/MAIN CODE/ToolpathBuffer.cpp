@@ -0,0 +1,442 @@
+#include"ToolpathBuffer.h"
+
+#include<algorithm>
+#include<cstring>
+
+#include<glm/gtc/packing.hpp>
+
+// Constructor that generates empty buffers, their textures on units slot and slot + 1, and the VAO
+ToolpathBuffer::ToolpathBuffer(GLuint slot)
+{
+	unit = slot;
+	tools = 0;
+	layerCount = 0;
+	positionOrigin = glm::vec3(0.0f);
+	positionScale = glm::vec3(1.0f);
+	speedMax = 1.0f;
+	flowMax = 1.0f;
+	glGenVertexArrays(1, &vaoID);
+	glGenBuffers(1, &ID);
+	glGenBuffers(1, &beadID);
+	glGenTextures(1, &pointTextureID);
+	glGenTextures(1, &beadTextureID);
+
+}
+
+// Bed tiles per side of the grid a layer is cut into
+static const int tilesPerSide = 8;
+static const int tilesPerLayer = tilesPerSide * tilesPerSide;
+
+// Full precision point the toolpath is sorted and simplified with before it is quantized
+struct BuildPoint
+{
+	glm::vec3 position;
+	float time;
+	// Layer with toolpathRunStart, as in ToolpathPoint
+	uint16_t layer;
+	uint8_t attributes[4];
+	glm::vec2 bead;
+};
+
+// Error of every simplified level as a fraction of the chunk's diagonal, level 0 is exact
+static const float levelTolerance[toolpathLevels] = { 0.0f, 1.0f / 256.0f, 1.0f / 64.0f, 1.0f / 16.0f };
+
+// Distance of a point from the segment a..b
+static float segmentDistance(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b)
+{
+	glm::vec3 ab = b - a;
+	float length2 = glm::dot(ab, ab);
+	float t = length2 > 0.0f ? glm::clamp(glm::dot(point - a, ab) / length2, 0.0f, 1.0f) : 0.0f;
+	return glm::length(point - (a + ab * t));
+}
+
+// Douglas-Peucker: marks the points of a polyline that stay so none of the dropped ones is further
+// than tolerance from the simplified line. The ends always stay.
+static void simplifyPolyline(const std::vector<BuildPoint>& points, float tolerance, std::vector<char>& keep,
+	std::vector<std::pair<size_t, size_t>>& stack)
+{
+	keep.assign(points.size(), 0);
+	keep.front() = 1;
+	keep.back() = 1;
+	stack.clear();
+	stack.push_back(std::make_pair((size_t)0, points.size() - 1));
+	while (!stack.empty())
+	{
+		size_t first = stack.back().first;
+		size_t last = stack.back().second;
+		stack.pop_back();
+		float worst = 0.0f;
+		size_t worstIndex = first;
+		for (size_t i = first + 1; i < last; i++)
+		{
+			float distance = segmentDistance(points[i].position, points[first].position, points[last].position);
+			if (distance > worst)
+			{
+				worst = distance;
+				worstIndex = i;
+			}
+		}
+		if (worst > tolerance)
+		{
+			keep[worstIndex] = 1;
+			stack.push_back(std::make_pair(first, worstIndex));
+			stack.push_back(std::make_pair(worstIndex, last));
+		}
+	}
+}
+
+// Appends the runs of a chunk simplified to tolerance to points. A kept point ends the simplified
+// move from the kept point before it and keeps its own attributes.
+static void simplifyChunk(std::vector<BuildPoint>& points, GLint first, GLsizei count, float tolerance)
+{
+	std::vector<BuildPoint> polyline;
+	std::vector<char> keep;
+	std::vector<std::pair<size_t, size_t>> stack;
+	for (GLint k = first; k < first + count; k++)
+	{
+		polyline.push_back(points[k]);
+		bool ends = k + 1 >= first + count || (points[k + 1].layer & toolpathRunStart);
+		if (!ends)
+			continue;
+
+		simplifyPolyline(polyline, tolerance, keep, stack);
+		// points may move while growing, the kept ones come from the polyline copy
+		for (size_t i = 0; i < polyline.size(); i++)
+		{
+			if (keep[i])
+				points.push_back(polyline[i]);
+		}
+		polyline.clear();
+	}
+}
+
+// Replaces the contents with the moves of a planned toolpath, flow has the volumetric flow of every move
+void ToolpathBuffer::Upload(const Toolpath& toolpath, const MotionPlan& plan, const std::vector<float>& flow, const PrinterProfile& profile)
+{
+	size_t count = toolpath.size();
+	tools = toolpath.toolCount;
+	int groups = moveStreams * tools;
+	layerCount = (int)toolpath.layerStart.size();
+	int stride = layerCount + 1;
+
+	// The tile grid spans the bed area the program uses
+	glm::vec2 areaMin(1e30f);
+	glm::vec2 areaMax(-1e30f);
+	for (size_t i = 0; i < count; i++)
+	{
+		areaMin = glm::min(areaMin, glm::vec2(toolpath.x[i], toolpath.z[i]));
+		areaMax = glm::max(areaMax, glm::vec2(toolpath.x[i], toolpath.z[i]));
+	}
+	glm::vec2 tileScale = (float)tilesPerSide / glm::max(areaMax - areaMin, glm::vec2(1e-6f));
+
+	// The color scales span the fastest move and the highest flow of the program
+	speedMax = 1e-6f;
+	flowMax = 1e-6f;
+	for (size_t i = 0; i < count; i++)
+	{
+		speedMax = std::max(speedMax, plan.cruiseSpeed[i]);
+		flowMax = std::max(flowMax, flow[i]);
+	}
+
+	// Thickness of every layer, layers that do not rise over the one before take the last real thickness
+	// or the profile's layer height
+	std::vector<float> thickness(layerCount);
+	float lastThickness = profile.layerHeight;
+	for (int layer = 0; layer < layerCount; layer++)
+	{
+		thickness[layer] = toolpath.layerHeight[layer] - (layer > 0 ? toolpath.layerHeight[layer - 1] : toolpath.origin.y);
+		if (thickness[layer] <= 0.0f)
+			thickness[layer] = lastThickness;
+		lastThickness = thickness[layer];
+	}
+
+	// Counting sort of the moves by stream, tool, layer and tile. Extruder only moves are retracts or
+	// primes and stay as moves of no length, other moves that go nowhere leave nothing to draw.
+	size_t buckets = (size_t)groups * layerCount * tilesPerLayer;
+	std::vector<size_t> bucketMoveFirst(buckets + 1, 0);
+	std::vector<unsigned> moveBucket(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 start = toolpath.startOf(i);
+		glm::vec3 end = toolpath.position(i);
+		MoveStream stream = toolpath.stream(i);
+		if (end == start && stream != STREAM_RETRACT)
+		{
+			moveBucket[i] = (unsigned)buckets;
+			continue;
+		}
+		glm::vec3 middle = (start + end) * 0.5f;
+		glm::ivec2 tile = glm::clamp(glm::ivec2((glm::vec2(middle.x, middle.z) - areaMin) * tileScale), 0, tilesPerSide - 1);
+		size_t group = (size_t)stream * tools + toolpath.tool[i];
+		size_t bucket = (group * layerCount + toolpath.layer[i]) * tilesPerLayer + tile.y * tilesPerSide + tile.x;
+		moveBucket[i] = (unsigned)bucket;
+		bucketMoveFirst[bucket + 1]++;
+	}
+	for (size_t bucket = 0; bucket < buckets; bucket++)
+		bucketMoveFirst[bucket + 1] += bucketMoveFirst[bucket];
+	std::vector<size_t> sortedMoves(bucketMoveFirst[buckets]);
+	std::vector<size_t> next(bucketMoveFirst.begin(), bucketMoveFirst.end() - 1);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (moveBucket[i] != buckets)
+			sortedMoves[next[moveBucket[i]]++] = i;
+	}
+
+	// A move that directly follows the previous move of its tile continues its run and only adds its end
+	// point, every other move starts a run with its start point. Perimeters and infill lines are long runs.
+	std::vector<BuildPoint> points;
+	points.reserve(sortedMoves.size() * 5 / 4);
+	std::vector<GLint> bucketFirst(buckets + 1, 0);
+	for (size_t bucket = 0; bucket < buckets; bucket++)
+	{
+		bucketFirst[bucket] = (GLint)points.size();
+		for (size_t k = bucketMoveFirst[bucket]; k < bucketMoveFirst[bucket + 1]; k++)
+		{
+			size_t i = sortedMoves[k];
+			BuildPoint point;
+			point.layer = (uint16_t)std::min(toolpath.layer[i], toolpathRunStart - 1);
+			point.attributes[ATTRIBUTE_SPEED] = (uint8_t)(plan.cruiseSpeed[i] / speedMax * 255.0f + 0.5f);
+			point.attributes[ATTRIBUTE_FLOW] = (uint8_t)(flow[i] / flowMax * 255.0f + 0.5f);
+			point.attributes[ATTRIBUTE_FAN] = toolpath.fan[i];
+			point.attributes[ATTRIBUTE_FEATURE] = (uint8_t)(std::min<int>(toolpath.feature[i], 15) << 4 | std::min<int>(toolpath.tool[i], 15));
+			if (k == bucketMoveFirst[bucket] || sortedMoves[k - 1] + 1 != i)
+			{
+				BuildPoint start = point;
+				start.layer |= toolpathRunStart;
+				start.position = toolpath.startOf(i);
+				start.time = (float)plan.startTime(i);
+				start.bead = glm::vec2(0.0f);
+				points.push_back(start);
+			}
+			// The extruded volume spread along the move gives the bead's cross section, a rectangle one layer high.
+			// Beads are capped at four layers wide so a stray E value does not swallow the view.
+			float height = thickness[toolpath.layer[i]];
+			float length = glm::length(toolpath.position(i) - toolpath.startOf(i));
+			float area = length > 0.0f ? std::max(flow[i], 0.0f) * plan.duration[i] / length : 0.0f;
+			point.bead = glm::vec2(height > 0.0f ? std::min(area / height, 4.0f * height) : 0.0f, height);
+			if (!toolpath.extrudes && toolpath.stream(i) == STREAM_EXTRUDE)
+				point.bead.x = profile.lineWidth;
+			point.position = toolpath.position(i);
+			point.time = (float)plan.endTime[i];
+			points.push_back(point);
+		}
+	}
+	bucketFirst[buckets] = (GLint)points.size();
+
+	// Range of every tool of every stream, then a chunk per non-empty bucket and the first chunk of every layer
+	toolFirst.assign(groups, 0);
+	toolCount.assign(groups, 0);
+	layerChunk.assign(groups * stride, 0);
+	chunks.clear();
+	for (int group = 0; group < groups; group++)
+	{
+		size_t toolBucket = (size_t)group * layerCount * tilesPerLayer;
+		toolFirst[group] = bucketFirst[toolBucket];
+		toolCount[group] = bucketFirst[toolBucket + (size_t)layerCount * tilesPerLayer] - toolFirst[group];
+		for (int layer = 0; layer <= layerCount; layer++)
+		{
+			size_t layerBucket = toolBucket + (size_t)layer * tilesPerLayer;
+			layerChunk[group * stride + layer] = chunks.size();
+			if (layer == layerCount)
+				break;
+			for (size_t bucket = layerBucket; bucket < layerBucket + tilesPerLayer; bucket++)
+			{
+				if (bucketFirst[bucket + 1] == bucketFirst[bucket])
+					continue;
+				ToolpathChunk chunk;
+				chunk.first = bucketFirst[bucket];
+				chunk.count = bucketFirst[bucket + 1] - chunk.first;
+				chunk.boundsMin = glm::vec3(1e30f);
+				chunk.boundsMax = glm::vec3(-1e30f);
+				for (GLint k = chunk.first; k < chunk.first + chunk.count; k++)
+				{
+					chunk.boundsMin = glm::min(chunk.boundsMin, points[k].position);
+					chunk.boundsMax = glm::max(chunk.boundsMax, points[k].position);
+				}
+				chunk.levelFirst[0] = chunk.first;
+				chunk.levelCount[0] = chunk.count;
+				chunk.levelError[0] = 0.0f;
+				chunks.push_back(chunk);
+			}
+		}
+	}
+
+	// Simplified levels go behind the full detail. A level that keeps more than half of the level
+	// before reuses it instead, which caps the extra memory below the size of the full detail.
+	for (ToolpathChunk& chunk : chunks)
+	{
+		float diagonal = glm::length(chunk.boundsMax - chunk.boundsMin);
+		for (int level = 1; level < toolpathLevels; level++)
+		{
+			GLint levelFirst = (GLint)points.size();
+			simplifyChunk(points, chunk.first, chunk.count, diagonal * levelTolerance[level]);
+			GLsizei levelCount = (GLsizei)points.size() - levelFirst;
+			if (levelCount * 2 > chunk.levelCount[level - 1])
+			{
+				points.resize(levelFirst);
+				levelFirst = chunk.levelFirst[level - 1];
+				levelCount = chunk.levelCount[level - 1];
+			}
+			chunk.levelFirst[level] = levelFirst;
+			chunk.levelCount[level] = levelCount;
+			chunk.levelError[level] = diagonal * levelTolerance[level];
+		}
+	}
+
+	// 16 bits over the program's box are a few micrometres on a real bed, well below what a nozzle lays down
+	glm::vec3 boxMin(1e30f);
+	glm::vec3 boxMax(-1e30f);
+	for (const BuildPoint& point : points)
+	{
+		boxMin = glm::min(boxMin, point.position);
+		boxMax = glm::max(boxMax, point.position);
+	}
+	positionOrigin = points.empty() ? glm::vec3(0.0f) : boxMin;
+	positionScale = points.empty() ? glm::vec3(1.0f) : glm::max(boxMax - boxMin, glm::vec3(1e-6f)) / 65535.0f;
+	std::vector<ToolpathPoint> packed(points.size());
+	std::vector<uint16_t> beads(points.size() * 2);
+	for (size_t k = 0; k < points.size(); k++)
+	{
+		glm::vec3 quantized = glm::round((points[k].position - positionOrigin) / positionScale);
+		for (int axis = 0; axis < 3; axis++)
+			packed[k].position[axis] = (uint16_t)glm::clamp(quantized[axis], 0.0f, 65535.0f);
+		packed[k].layer = points[k].layer;
+		packed[k].time = points[k].time;
+		memcpy(packed[k].attributes, points[k].attributes, sizeof(packed[k].attributes));
+		beads[2 * k] = glm::packHalf1x16(points[k].bead.x);
+		beads[2 * k + 1] = glm::packHalf1x16(points[k].bead.y);
+	}
+
+	// The textures are attached after the data so they always see the buffers' current storage
+	glBindBuffer(GL_TEXTURE_BUFFER, ID);
+	glBufferData(GL_TEXTURE_BUFFER, packed.size() * sizeof(ToolpathPoint), packed.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, beadID);
+	glBufferData(GL_TEXTURE_BUFFER, beads.size() * sizeof(uint16_t), beads.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, pointTextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, ID);
+	glBindTexture(GL_TEXTURE_BUFFER, beadTextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG16F, beadID);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+// Chunks of a tool's moves of one stream in layers firstLayer..lastLayer, as [begin, end) into chunks
+void ToolpathBuffer::LayerChunks(MoveStream stream, int tool, int firstLayer, int lastLayer, size_t& begin, size_t& end) const
+{
+	firstLayer = std::max(firstLayer, 0);
+	lastLayer = std::min(lastLayer, layerCount - 1);
+	if (firstLayer > lastLayer)
+	{
+		begin = 0;
+		end = 0;
+		return;
+	}
+	const size_t* layers = &layerChunk[(stream * tools + tool) * (layerCount + 1)];
+	begin = layers[firstLayer];
+	end = layers[lastLayer + 1];
+}
+
+// Collects the visible chunks of one stream in layers firstLayer..lastLayer into list
+void ToolpathBuffer::Collect(MoveStream stream, const Frustum& frustum, const glm::vec3& eye, int firstLayer, int lastLayer, float pixelsPerUnit,
+	float maxErrorPixels, ToolpathDrawList& list) const
+{
+	list.first.clear();
+	list.count.clear();
+	list.points = 0;
+	for (int tool = 0; tool < tools; tool++)
+	{
+		size_t begin, end;
+		LayerChunks(stream, tool, firstLayer, lastLayer, begin, end);
+		for (size_t i = begin; i < end; i++)
+		{
+			const ToolpathChunk& chunk = chunks[i];
+			if (!frustum.intersects(chunk.boundsMin, chunk.boundsMax))
+				continue;
+			glm::vec3 nearest = glm::clamp(eye, chunk.boundsMin, chunk.boundsMax);
+			float distance = std::max(glm::length(eye - nearest), 1e-4f);
+			int level = toolpathLevels - 1;
+			while (level > 0 && chunk.levelError[level] * pixelsPerUnit / distance > maxErrorPixels)
+				level--;
+			GLint levelFirst = chunk.levelFirst[level];
+			GLsizei levelCount = chunk.levelCount[level];
+			if (!list.first.empty() && list.first.back() + list.count.back() == levelFirst)
+			{
+				list.count.back() += levelCount;
+			}
+			else
+			{
+				list.first.push_back(levelFirst);
+				list.count.push_back(levelCount);
+			}
+			list.points += levelCount;
+		}
+	}
+}
+
+// Binds the point and bead textures to their units
+static void bindTextures(GLuint unit, GLuint pointTexture, GLuint beadTexture)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, pointTexture);
+	glActiveTexture(GL_TEXTURE0 + unit + 1);
+	glBindTexture(GL_TEXTURE_BUFFER, beadTexture);
+}
+
+// Turns the point ranges of list into vertex ranges with verticesPerPoint vertices for every point
+static void vertexRanges(ToolpathDrawList& list, GLint verticesPerPoint)
+{
+	list.vertexFirst.resize(list.size());
+	list.vertexCount.resize(list.size());
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		list.vertexFirst[i] = list.first[i] * verticesPerPoint;
+		list.vertexCount[i] = list.count[i] * verticesPerPoint;
+	}
+}
+
+// Binds the textures and the VAO
+void ToolpathBuffer::Bind()
+{
+	bindTextures(unit, pointTextureID, beadTextureID);
+	glBindVertexArray(vaoID);
+}
+
+// Draws the moves of the list as lines with toolpath.vert, the VAO has to be bound
+void ToolpathBuffer::DrawLines(ToolpathDrawList& list)
+{
+	// Every point gives the line of the move that ends at it, the two vertices fetch its ends
+	vertexRanges(list, 2);
+	glMultiDrawArrays(GL_LINES, list.vertexFirst.data(), list.vertexCount.data(), (GLsizei)list.size());
+}
+
+// Draws both ends of the moves of the list as points with toolpath.vert, the VAO has to be bound
+void ToolpathBuffer::DrawPoints(ToolpathDrawList& list)
+{
+	vertexRanges(list, 2);
+	glMultiDrawArrays(GL_POINTS, list.vertexFirst.data(), list.vertexCount.data(), (GLsizei)list.size());
+}
+
+// Draws the moves of the list as tubes with tube.vert, the VAO has to be bound
+void ToolpathBuffer::DrawTubes(ToolpathDrawList& list)
+{
+	// Every point gives the tube of the move that ends at it, the vertices take their corner from gl_VertexID
+	vertexRanges(list, tubeVertices);
+	glMultiDrawArrays(GL_TRIANGLES, list.vertexFirst.data(), list.vertexCount.data(), (GLsizei)list.size());
+}
+
+// Unbinds the VAO and the textures
+void ToolpathBuffer::Unbind()
+{
+	glBindVertexArray(0);
+	bindTextures(unit, 0, 0);
+}
+
+// Deletes the buffers, the textures and the VAO
+void ToolpathBuffer::Delete()
+{
+	glDeleteVertexArrays(1, &vaoID);
+	glDeleteBuffers(1, &ID);
+	glDeleteBuffers(1, &beadID);
+	glDeleteTextures(1, &pointTextureID);
+	glDeleteTextures(1, &beadTextureID);
+}
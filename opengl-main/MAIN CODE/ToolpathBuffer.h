@@ -0,0 +1,140 @@
+#ifndef TOOLPATH_BUFFER_CLASS_H
+#define TOOLPATH_BUFFER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<glad/glad.h>
+#include<cstdint>
+#include<vector>
+
+#include"Frustum.h"
+#include"Gcode.h"
+#include"Planner.h"
+#include"PrinterProfile.h"
+
+// Packed per-move attributes of ToolpathPoint, the coloring picks one of them in toolpath.glsl
+enum ToolpathAttribute
+{
+	ATTRIBUTE_SPEED,   // Cruise speed over ToolpathBuffer::speedMax, 0..255
+	ATTRIBUTE_FLOW,    // Volumetric flow over ToolpathBuffer::flowMax, 0..255
+	ATTRIBUTE_FAN,     // Fan duty, 0..255
+	ATTRIBUTE_FEATURE  // Feature index (capped at 15) in the high 4 bits, tool (capped at 15) in the low 4 bits
+};
+
+// Point of the uploaded toolpath in 16 bytes, one texel of the buffer texture the shaders fetch from.
+// Moves that follow each other share their points: every point ends the move from the point before it
+// and carries that move's attributes. The position is quantized to 16 bits per axis over the box of the
+// whole program, time is when the head passes the point.
+struct ToolpathPoint
+{
+	uint16_t position[3];
+	// Layer of the move that ends here, toolpathRunStart is set on the first point of every run
+	uint16_t layer;
+	float time;
+	// Indexed by ToolpathAttribute
+	uint8_t attributes[4];
+};
+
+// Marks a point that only starts a run of connected moves, no move ends there
+const uint16_t toolpathRunStart = 0x8000;
+
+// Vertices of the tube every move is drawn as, two triangles on each side of a square cross section,
+// tube.vert has the same count
+const int tubeVertices = 24;
+
+// Detail levels of every chunk, level 0 is the full toolpath
+const int toolpathLevels = 4;
+
+// Moves of one tool in one layer and one bed tile, a range of points with the box around it
+struct ToolpathChunk
+{
+	GLint first;
+	GLsizei count;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	// Ranges of the chunk simplified to every level, level 0 is first and count. Connected moves are
+	// simplified as polylines, no dropped point is further than levelError from the drawn lines.
+	GLint levelFirst[toolpathLevels];
+	GLsizei levelCount[toolpathLevels];
+	float levelError[toolpathLevels];
+};
+
+// Point ranges to draw in one call, kept between frames so collecting and drawing them does not allocate
+struct ToolpathDrawList
+{
+	std::vector<GLint> first;
+	std::vector<GLsizei> count;
+	// Points in all ranges
+	size_t points = 0;
+	// The ranges as vertices of the primitives they are drawn with, filled by the draw calls
+	std::vector<GLint> vertexFirst;
+	std::vector<GLsizei> vertexCount;
+
+	size_t size() const { return first.size(); }
+};
+
+// Whole toolpath of a program in static buffer textures, uploaded once and revealed by the shader
+// up to the playback time. The shaders have no vertex attributes, they fetch the points of their move by
+// gl_VertexID, see toolpath.vert and tube.vert. Moves are sorted by MoveStream, tool, layer,
+// then the bed tile their middle lies in, program order is kept within a tile. So each stream is one
+// range of the buffer, each tool one range within it, each run of layers one range within that, and each
+// tile of a layer a chunk. Hiding a stream only leaves its range out. The simplified levels of all chunks
+// follow the full detail ranges.
+class ToolpathBuffer
+{
+public:
+	// ID reference of the empty Vertex Array Object the core profile needs for drawing
+	GLuint vaoID;
+	// ID reference of the buffer with the ToolpathPoints
+	GLuint ID;
+	// Width and height of the bead of the move that ends at every point as half floats,
+	// 0 wide for moves that do not extrude
+	GLuint beadID;
+	// Buffer textures over the points and the beads, bound to unit and unit + 1
+	GLuint pointTextureID;
+	GLuint beadTextureID;
+	GLuint unit;
+	// Decodes the quantized positions: origin + position * scale
+	glm::vec3 positionOrigin;
+	glm::vec3 positionScale;
+	// Speed and flow that map to the top of the color scale
+	float speedMax;
+	float flowMax;
+	int tools;
+	// First point and point count of every tool in every stream, indexed stream * tools + tool
+	std::vector<GLint> toolFirst;
+	std::vector<GLsizei> toolCount;
+	int layerCount;
+	// Non-empty chunks in buffer order
+	std::vector<ToolpathChunk> chunks;
+	// First chunk of every layer of every tool in every stream, layerCount + 1 entries per tool,
+	// the last one is the end of the tool's chunks
+	std::vector<size_t> layerChunk;
+
+	// Constructor that generates empty buffers, their textures on units slot and slot + 1, and the VAO
+	ToolpathBuffer(GLuint slot);
+
+	// Replaces the contents with the moves of a planned toolpath, flow has the volumetric flow of every move.
+	// The profile's line width and layer height size the beads the program does not.
+	void Upload(const Toolpath& toolpath, const MotionPlan& plan, const std::vector<float>& flow, const PrinterProfile& profile);
+	// Chunks of a tool's moves of one stream in layers firstLayer..lastLayer, as [begin, end) into chunks
+	void LayerChunks(MoveStream stream, int tool, int firstLayer, int lastLayer, size_t& begin, size_t& end) const;
+	// Collects the visible chunks of one stream in layers firstLayer..lastLayer into list. Every chunk takes the
+	// coarsest level whose error seen from eye stays under maxErrorPixels, pixelsPerUnit is the screen size
+	// of one unit at distance 1. Ranges that touch in the buffer are merged, also across chunks and tools.
+	void Collect(MoveStream stream, const Frustum& frustum, const glm::vec3& eye, int firstLayer, int lastLayer, float pixelsPerUnit,
+		float maxErrorPixels, ToolpathDrawList& list) const;
+	// Binds the textures and the VAO
+	void Bind();
+	// Draws the moves of the list as lines with toolpath.vert, the VAO has to be bound
+	void DrawLines(ToolpathDrawList& list);
+	// Draws both ends of the moves of the list as points with toolpath.vert, the VAO has to be bound
+	void DrawPoints(ToolpathDrawList& list);
+	// Draws the moves of the list as tubes with tube.vert, the VAO has to be bound
+	void DrawTubes(ToolpathDrawList& list);
+	// Unbinds the VAO and the textures
+	void Unbind();
+	// Deletes the buffers, the textures and the VAO
+	void Delete();
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include"ToolpathBvh.h"
+
+#include<algorithm>
+
+// Moves per block, a block is built in one go and is small enough to stay in cache while it is
+static const size_t blockSize = 4096;
+// Entries a leaf keeps at most
+static const uint32_t leafSize = 8;
+
+// Box of an entry while a tree is built
+struct BuildBox
+{
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	glm::vec3 center;
+};
+
+// Builds the tree over entries[first, first + count) into nodes below the node at index, splitting at
+// the median along the longest axis of the entry centers. boxes is indexed by entry - boxBase.
+static void buildNode(std::vector<BvhNode>& nodes, uint32_t index, std::vector<uint32_t>& entries, uint32_t first,
+	uint32_t count, const std::vector<BuildBox>& boxes, uint32_t boxBase)
+{
+	glm::vec3 boundsMin(1e30f), boundsMax(-1e30f), centerMin(1e30f), centerMax(-1e30f);
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const BuildBox& box = boxes[entries[i] - boxBase];
+		boundsMin = glm::min(boundsMin, box.boundsMin);
+		boundsMax = glm::max(boundsMax, box.boundsMax);
+		centerMin = glm::min(centerMin, box.center);
+		centerMax = glm::max(centerMax, box.center);
+	}
+	nodes[index].boundsMin = boundsMin;
+	nodes[index].boundsMax = boundsMax;
+	if (count <= leafSize)
+	{
+		nodes[index].first = first;
+		nodes[index].count = count;
+		return;
+	}
+
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	uint32_t half = count / 2;
+	std::nth_element(entries.begin() + first, entries.begin() + first + half, entries.begin() + first + count,
+		[&](uint32_t a, uint32_t b) { return boxes[a - boxBase].center[axis] < boxes[b - boxBase].center[axis]; });
+
+	uint32_t children = (uint32_t)nodes.size();
+	nodes.resize(nodes.size() + 2);
+	nodes[index].first = children;
+	nodes[index].count = 0;
+	buildNode(nodes, children, entries, first, half, boxes, boxBase);
+	buildNode(nodes, children + 1, entries, first + half, count - half, boxes, boxBase);
+}
+
+// Builds a tree over entries[first, first + count) and returns its root
+static uint32_t buildTree(std::vector<BvhNode>& nodes, std::vector<uint32_t>& entries, uint32_t first, uint32_t count,
+	const std::vector<BuildBox>& boxes, uint32_t boxBase)
+{
+	uint32_t root = (uint32_t)nodes.size();
+	nodes.resize(nodes.size() + 1);
+	buildNode(nodes, root, entries, first, count, boxes, boxBase);
+	return root;
+}
+
+// Removes all blocks
+void ToolpathBvh::clear()
+{
+	nodes.clear();
+	moves.clear();
+	blockRoots.clear();
+	topNodes.clear();
+	topBlocks.clear();
+	built = 0;
+}
+
+// Adds the moves of the toolpath that are not in the hierarchy yet
+void ToolpathBvh::append(const Toolpath& toolpath)
+{
+	// The last block may be partial, it is built again with the new moves. Its nodes and moves are the last ones.
+	if (blockRoots.size() * blockSize > built)
+	{
+		nodes.resize(blockRoots.back());
+		moves.resize(built);
+		blockRoots.pop_back();
+	}
+
+	std::vector<BuildBox> boxes;
+	size_t count = toolpath.size();
+	for (size_t blockFirst = built; blockFirst < count; blockFirst += blockSize)
+	{
+		size_t blockEnd = std::min(blockFirst + blockSize, count);
+		boxes.resize(blockEnd - blockFirst);
+		for (size_t i = blockFirst; i < blockEnd; i++)
+		{
+			glm::vec3 start = toolpath.startOf(i);
+			glm::vec3 end = toolpath.position(i);
+			boxes[i - blockFirst].boundsMin = glm::min(start, end);
+			boxes[i - blockFirst].boundsMax = glm::max(start, end);
+			boxes[i - blockFirst].center = (start + end) * 0.5f;
+			moves.push_back((uint32_t)i);
+		}
+		blockRoots.push_back(buildTree(nodes, moves, (uint32_t)blockFirst, (uint32_t)(blockEnd - blockFirst), boxes, (uint32_t)blockFirst));
+		if (blockEnd - blockFirst == blockSize)
+			built = blockEnd;
+	}
+
+	// The top tree is small, a block per few thousand moves, and is simply built again
+	topNodes.clear();
+	topBlocks.resize(blockRoots.size());
+	boxes.resize(blockRoots.size());
+	for (size_t block = 0; block < blockRoots.size(); block++)
+	{
+		topBlocks[block] = (uint32_t)block;
+		boxes[block].boundsMin = nodes[blockRoots[block]].boundsMin;
+		boxes[block].boundsMax = nodes[blockRoots[block]].boundsMax;
+		boxes[block].center = (boxes[block].boundsMin + boxes[block].boundsMax) * 0.5f;
+	}
+	if (!blockRoots.empty())
+		buildTree(topNodes, topBlocks, 0, (uint32_t)blockRoots.size(), boxes, 0);
+}
+
+// Distance along the ray to where it enters the box grown by margin, -1 if it misses or enters past limit
+static float rayBox(const glm::vec3& origin, const glm::vec3& inverse, const BvhNode& node, float margin, float limit)
+{
+	glm::vec3 low = (node.boundsMin - margin - origin) * inverse;
+	glm::vec3 high = (node.boundsMax + margin - origin) * inverse;
+	glm::vec3 entering = glm::min(low, high);
+	glm::vec3 leaving = glm::max(low, high);
+	float enter = std::max(std::max(entering.x, entering.y), std::max(entering.z, 0.0f));
+	float leave = std::min(std::min(leaving.x, leaving.y), leaving.z);
+	return enter <= leave && enter <= limit ? enter : -1.0f;
+}
+
+// Margin the box of a node needs so every segment within angle of the ray, seen from origin, still hits it
+static float pickMargin(const glm::vec3& origin, const BvhNode& node, float angle)
+{
+	glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+	float reach = glm::length(center - origin) + glm::length(node.boundsMax - center);
+	return angle * reach;
+}
+
+// Closest points of the ray origin + t * direction (t >= 0, direction of unit length) and the segment a..b,
+// returns the distance between them and the ray parameter and point on the segment
+static float raySegment(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b,
+	float& t, glm::vec3& point)
+{
+	glm::vec3 ab = b - a;
+	glm::vec3 w = a - origin;
+	float abab = glm::dot(ab, ab);
+	float dab = glm::dot(direction, ab);
+	float dw = glm::dot(direction, w);
+	float abw = glm::dot(ab, w);
+	float denominator = abab - dab * dab;
+	// Parallel rays and points take the segment start
+	float s = denominator > 1e-12f ? (dab * dw - abw) / denominator : 0.0f;
+	s = abab > 0.0f ? glm::clamp(s, 0.0f, 1.0f) : 0.0f;
+	point = a + ab * s;
+	t = std::max(glm::dot(point - origin, direction), 0.0f);
+	return glm::length(origin + direction * t - point);
+}
+
+// Finds the move nearest to the ray origin among the ones that pass within angle of the ray
+bool ToolpathBvh::pick(const Toolpath& toolpath, const glm::vec3& origin, const glm::vec3& direction, float angle,
+	const PickFilter& filter, ToolpathPick& result) const
+{
+	if (topNodes.empty())
+		return false;
+	glm::vec3 inverse = 1.0f / direction;
+	float best = 1e30f;
+	bool found = false;
+
+	// Nodes are visited depth first, the nearer child first, and skipped once they start past the best hit.
+	// An entry of the stack is a node index with the top tree marked by the high bit.
+	const uint32_t top = 0x80000000u;
+	std::vector<uint32_t> stack;
+	stack.push_back(top);
+	while (!stack.empty())
+	{
+		uint32_t entry = stack.back();
+		stack.pop_back();
+		bool inTop = (entry & top) != 0;
+		const BvhNode& node = inTop ? topNodes[entry & ~top] : nodes[entry];
+		if (rayBox(origin, inverse, node, pickMargin(origin, node, angle), best) < 0.0f)
+			continue;
+
+		if (node.count == 0)
+		{
+			const std::vector<BvhNode>& tree = inTop ? topNodes : nodes;
+			uint32_t nearer = node.first;
+			uint32_t further = node.first + 1;
+			glm::vec3 nearerCenter = tree[nearer].boundsMin + tree[nearer].boundsMax;
+			glm::vec3 furtherCenter = tree[further].boundsMin + tree[further].boundsMax;
+			if (glm::dot(furtherCenter - nearerCenter, direction) < 0.0f)
+				std::swap(nearer, further);
+			uint32_t mark = inTop ? top : 0;
+			stack.push_back(further | mark);
+			stack.push_back(nearer | mark);
+		}
+		else if (inTop)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+				stack.push_back(blockRoots[topBlocks[i]]);
+		}
+		else
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				size_t move = moves[i];
+				if (move >= filter.moveEnd || toolpath.layer[move] < filter.firstLayer || toolpath.layer[move] > filter.lastLayer
+					|| !filter.streams[toolpath.stream(move)])
+					continue;
+				float t;
+				glm::vec3 point;
+				float distance = raySegment(origin, direction, toolpath.startOf(move), toolpath.position(move), t, point);
+				if (distance > angle * t || t >= best)
+					continue;
+				bool cut = false;
+				for (const glm::vec4& plane : filter.planes)
+					cut = cut || glm::dot(glm::vec4(point, 1.0f), plane) < 0.0f;
+				if (cut)
+					continue;
+				best = t;
+				found = true;
+				result.move = move;
+				result.point = point;
+				result.depth = t;
+			}
+		}
+	}
+	return found;
+}
@@ -0,0 +1,71 @@
+#ifndef TOOLPATH_BVH_CLASS_H
+#define TOOLPATH_BVH_CLASS_H
+
+#include<glm/glm.hpp>
+#include<cstdint>
+#include<vector>
+
+#include"Gcode.h"
+
+// Box of a subtree, inner nodes point at their two children, leaves at a range of entries
+struct BvhNode
+{
+	glm::vec3 boundsMin;
+	// First of the two children of an inner node, first entry of a leaf
+	uint32_t first;
+	glm::vec3 boundsMax;
+	// Entries of a leaf, 0 for inner nodes
+	uint32_t count;
+};
+
+// Moves a pick may return
+struct PickFilter
+{
+	int firstLayer = 0;
+	int lastLayer = 1 << 30;
+	// Moves from this one on are not printed yet
+	size_t moveEnd = SIZE_MAX;
+	bool streams[moveStreams] = { true, true, true };
+	// Section planes in use as (normal, distance), hits on their negative side are cut away
+	std::vector<glm::vec4> planes;
+};
+
+// Move found under the cursor
+struct ToolpathPick
+{
+	size_t move;
+	// Closest point of the move to the ray and how far along the ray it lies
+	glm::vec3 point;
+	float depth;
+};
+
+// Bounding volume hierarchy over the segments of a toolpath for picking. Moves are taken in blocks of
+// program order as they are appended, every block gets its own tree and a small top tree over the
+// blocks is rebuilt after every append, so appending to a grown toolpath only builds the new blocks.
+// The viewer parses a program within one frame and appends the whole toolpath once after the parse,
+// it is not built while the file loads.
+class ToolpathBvh
+{
+public:
+	// Trees of all blocks in one array, entries of their leaves are move indices
+	std::vector<BvhNode> nodes;
+	std::vector<uint32_t> moves;
+	// Root node of every block
+	std::vector<uint32_t> blockRoots;
+	// Tree over the blocks, entries of its leaves are block indices
+	std::vector<BvhNode> topNodes;
+	std::vector<uint32_t> topBlocks;
+	// Moves of the toolpath in complete blocks, the moves after them are in the last block
+	size_t built = 0;
+
+	// Removes all blocks
+	void clear();
+	// Adds the moves of the toolpath that are not in the hierarchy yet
+	void append(const Toolpath& toolpath);
+	// Finds the move nearest to the ray origin among the ones that pass within angle (in radians,
+	// the size of a few pixels) of the ray. False if there is none.
+	bool pick(const Toolpath& toolpath, const glm::vec3& origin, const glm::vec3& direction, float angle,
+		const PickFilter& filter, ToolpathPick& result) const;
+};
+
+#endif
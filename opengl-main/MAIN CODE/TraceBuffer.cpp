@@ -0,0 +1,76 @@
+#include"TraceBuffer.h"
+
+#include<algorithm>
+
+// Room of a new buffer, enough for a few seconds of playback
+static const GLsizeiptr initialCapacity = 4096;
+
+// Constructor that generates an empty buffer and its VAO
+TraceBuffer::TraceBuffer()
+{
+	capacity = 0;
+	glGenVertexArrays(1, &vaoID);
+	glGenBuffers(1, &ID);
+}
+
+// Writes count vertices starting at vertex first, growing the buffer if they do not fit
+void TraceBuffer::Write(GLintptr first, const glm::vec3* vertices, GLsizeiptr count)
+{
+	if (count <= 0)
+		return;
+	if (first + count > capacity)
+		Grow(first + count, first);
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), count * sizeof(glm::vec3), vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Moves the first keep vertices into a buffer with room for at least needed vertices
+void TraceBuffer::Grow(GLsizeiptr needed, GLsizeiptr keep)
+{
+	// Doubling keeps the copies down to a constant amount per vertex over the whole print
+	GLsizeiptr newCapacity = std::max(initialCapacity, capacity * 2);
+	while (newCapacity < needed)
+		newCapacity *= 2;
+
+	GLuint newID;
+	glGenBuffers(1, &newID);
+	glBindBuffer(GL_ARRAY_BUFFER, newID);
+	glBufferData(GL_ARRAY_BUFFER, newCapacity * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+	if (keep > 0)
+	{
+		// The copy stays on the GPU
+		glBindBuffer(GL_COPY_READ_BUFFER, ID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, keep * sizeof(glm::vec3));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &ID);
+	ID = newID;
+	capacity = newCapacity;
+
+	// Points the VAO at the new buffer
+	glBindVertexArray(vaoID);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Binds the VAO
+void TraceBuffer::Bind()
+{
+	glBindVertexArray(vaoID);
+}
+
+// Unbinds the VAO
+void TraceBuffer::Unbind()
+{
+	glBindVertexArray(0);
+}
+
+// Deletes the buffer and the VAO
+void TraceBuffer::Delete()
+{
+	glDeleteVertexArrays(1, &vaoID);
+	glDeleteBuffers(1, &ID);
+}
@@ -0,0 +1,36 @@
+#ifndef TRACE_BUFFER_CLASS_H
+#define TRACE_BUFFER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<glad/glad.h>
+
+// Vertex buffer of a trace that stays alive between frames, vertices are written where they changed
+// and the buffer doubles when it runs out of room, so a frame only uploads what is new
+class TraceBuffer
+{
+public:
+	// ID reference of the Vertex Array Object that reads positions from the buffer
+	GLuint vaoID;
+	// ID reference of the Vertex Buffer Object
+	GLuint ID;
+	// Vertices the buffer has room for
+	GLsizeiptr capacity;
+
+	// Constructor that generates an empty buffer and its VAO
+	TraceBuffer();
+
+	// Writes count vertices starting at vertex first, growing the buffer if they do not fit
+	void Write(GLintptr first, const glm::vec3* vertices, GLsizeiptr count);
+	// Binds the VAO
+	void Bind();
+	// Unbinds the VAO
+	void Unbind();
+	// Deletes the buffer and the VAO
+	void Delete();
+
+private:
+	// Moves the first keep vertices into a buffer with room for at least needed vertices
+	void Grow(GLsizeiptr needed, GLsizeiptr keep);
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include"TraceSpill.h"
+
+#include<chrono>
+#include<cstring>
+#include<filesystem>
+#include<string>
+
+// Stored 7 bits per byte, small values take one or two bytes
+static void putVarint(std::vector<unsigned char>& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+static bool getVarint(const unsigned char*& data, const unsigned char* end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35 && data < end; shift += 7)
+	{
+		unsigned char byte = *data++;
+		value |= (uint32_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static float bitsFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+TraceSpill::TraceSpill()
+{
+	file = NULL;
+	open();
+}
+
+// Closes and deletes the file
+TraceSpill::~TraceSpill()
+{
+	close();
+}
+
+// tmpfile() puts its files in the root of the drive on Windows, where writing needs admin rights
+void TraceSpill::open()
+{
+	std::error_code error;
+	std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+	if (error)
+		return;
+	// The clock and the address keep several spills and viewers apart
+	std::string name = "trace-spill-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+		"-" + std::to_string((uintptr_t)this) + ".bin";
+	path = (directory / name).string();
+	file = fopen(path.c_str(), "w+b");
+}
+
+void TraceSpill::close()
+{
+	if (file == NULL)
+		return;
+	fclose(file);
+	file = NULL;
+	remove(path.c_str());
+}
+
+// Appends a chunk of a tool's trace made of strips with the given vertex counts
+bool TraceSpill::spill(int tool, const glm::vec3* vertices, const uint32_t* stripCounts, size_t strips)
+{
+	if (file == NULL)
+		return false;
+
+	SpilledChunk chunk;
+	chunk.tool = tool;
+	chunk.vertices = 0;
+	chunk.boundsMin = glm::vec3(1e30f);
+	chunk.boundsMax = glm::vec3(-1e30f);
+
+	std::vector<unsigned char> data;
+	putVarint(data, (uint32_t)strips);
+	for (size_t i = 0; i < strips; i++)
+	{
+		putVarint(data, stripCounts[i]);
+		chunk.vertices += stripCounts[i];
+	}
+	uint32_t previous[3] = { 0, 0, 0 };
+	for (uint32_t i = 0; i < chunk.vertices; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			uint32_t bits = floatBits(vertices[i][axis]);
+			// Nearby floats share sign, exponent and the top of the mantissa, only the low bits are left
+			putVarint(data, bits ^ previous[axis]);
+			previous[axis] = bits;
+		}
+		chunk.boundsMin = glm::min(chunk.boundsMin, vertices[i]);
+		chunk.boundsMax = glm::max(chunk.boundsMax, vertices[i]);
+	}
+
+	if (fseek(file, 0, SEEK_END) != 0)
+		return false;
+	chunk.offset = ftell(file);
+	chunk.bytes = (uint32_t)data.size();
+	if (fwrite(data.data(), 1, data.size(), file) != data.size())
+		return false;
+
+	chunks.push_back(chunk);
+	spilledVertices += chunk.vertices;
+	spilledBytes += chunk.bytes;
+	return true;
+}
+
+// Reads a chunk back
+bool TraceSpill::load(size_t index, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& stripCounts) const
+{
+	vertices.clear();
+	stripCounts.clear();
+	if (file == NULL || index >= chunks.size())
+		return false;
+
+	const SpilledChunk& chunk = chunks[index];
+	std::vector<unsigned char> data(chunk.bytes);
+	if (fseek(file, chunk.offset, SEEK_SET) != 0 || fread(data.data(), 1, data.size(), file) != data.size())
+		return false;
+
+	const unsigned char* cursor = data.data();
+	const unsigned char* end = cursor + data.size();
+	uint32_t strips;
+	if (!getVarint(cursor, end, strips))
+		return false;
+	stripCounts.resize(strips);
+	for (uint32_t i = 0; i < strips; i++)
+	{
+		if (!getVarint(cursor, end, stripCounts[i]))
+			return false;
+	}
+	vertices.resize(chunk.vertices);
+	uint32_t previous[3] = { 0, 0, 0 };
+	for (uint32_t i = 0; i < chunk.vertices; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			uint32_t delta;
+			if (!getVarint(cursor, end, delta))
+				return false;
+			previous[axis] ^= delta;
+			vertices[i][axis] = bitsFloat(previous[axis]);
+		}
+	}
+	return true;
+}
+
+// Drops every chunk and empties the file
+void TraceSpill::clear()
+{
+	chunks.clear();
+	spilledVertices = 0;
+	spilledBytes = 0;
+	close();
+	open();
+}
@@ -0,0 +1,57 @@
+#ifndef TRACE_SPILL_CLASS_H
+#define TRACE_SPILL_CLASS_H
+
+#include<glm/glm.hpp>
+#include<cstdint>
+#include<cstdio>
+#include<string>
+#include<vector>
+
+// Piece of a trace moved out of memory
+struct SpilledChunk
+{
+	int tool;
+	// Where the compressed chunk sits in the file
+	long offset;
+	uint32_t bytes;
+	uint32_t vertices;
+	// Box around the vertices, decides which chunks a view needs back
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
+
+// Old trace history kept compressed in a file in the temporary directory, the file is deleted when the spill is closed.
+// Vertices are stored losslessly: every coordinate as the XOR of its bits with the previous vertex's,
+// which is small for neighbouring points, written 7 bits per byte.
+class TraceSpill
+{
+public:
+	std::vector<SpilledChunk> chunks;
+	// Totals over all chunks
+	size_t spilledVertices = 0;
+	size_t spilledBytes = 0;
+
+	TraceSpill();
+	// Closes and deletes the file
+	~TraceSpill();
+	TraceSpill(const TraceSpill&) = delete;
+	TraceSpill& operator=(const TraceSpill&) = delete;
+
+	// Appends a chunk of a tool's trace made of strips with the given vertex counts,
+	// returns false if the file cannot be written
+	bool spill(int tool, const glm::vec3* vertices, const uint32_t* stripCounts, size_t strips);
+	// Reads a chunk back, returns false if the file cannot be read
+	bool load(size_t chunk, std::vector<glm::vec3>& vertices, std::vector<uint32_t>& stripCounts) const;
+	// Drops every chunk and empties the file
+	void clear();
+
+private:
+	FILE* file;
+	std::string path;
+
+	// Creates a new empty file, file stays NULL if it cannot be created
+	void open();
+	void close();
+};
+
+#endif
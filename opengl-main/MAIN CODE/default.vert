@@ -25,12 +25,15 @@ out vec2 texCoord;
 uniform mat4 camMatrix;
 // Imports the model matrix from the main function
 uniform mat4 model;
+#include "section.glsl"
 
 
 void main()
 {
 	// calculates current position
 	crntPos = vec3(model * vec4(aPos, 1.0f));
+	// distance of the position from every section plane
+	clipSections(crntPos);
 	// Assigns the normal from the Vertex Data to "Normal"
 	Normal = aNormal;
 	// Assigns the colors from the Vertex Data to "color"
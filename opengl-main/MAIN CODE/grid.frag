@@ -0,0 +1,49 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 bedPos;
+
+uniform vec3 bedMin;
+uniform vec3 bedMax;
+
+// Minor lines are never closer than this on screen, the spacing steps by 10 as the view zooms
+const float minPixels = 8.0;
+
+// Coverage of the grid lines of a spacing at this fragment, one pixel wide and anti-aliased
+float gridLines(vec2 position, vec2 pixel, float spacing)
+{
+    vec2 distance = abs(fract(position / spacing + 0.5) - 0.5) * spacing / pixel;
+    return 1.0 - min(min(distance.x, distance.y), 1.0);
+}
+
+void main()
+{
+    // Size of a pixel on the bed, the log rounded up picks the smallest power of 10 that keeps minor lines
+    // at least minPixels apart, they are minPixels to 10 times that apart on screen
+    vec2 pixel = max(fwidth(bedPos), vec2(1e-6));
+    float level = log(max(pixel.x, pixel.y) * minPixels) / log(10.0);
+    float minor = pow(10.0, ceil(level));
+    // Minor lines fade out as they close in on minPixels, so stepping to the next spacing does not pop
+    float fade = 1.0 - fract(level);
+
+    float lines = max(gridLines(bedPos, pixel, minor) * fade * 0.35,
+        max(gridLines(bedPos, pixel, minor * 10.0) * 0.6, gridLines(bedPos, pixel, minor * 100.0)));
+    vec3 color = vec3(1.0);
+
+    // The axes through the origin and the bed edges stand out
+    vec2 axis = abs(bedPos) / pixel;
+    if (axis.y < 1.0) {
+        color = vec3(1.0, 0.35, 0.35);
+        lines = max(lines, 1.0 - axis.y);
+    }
+    if (axis.x < 1.0) {
+        color = vec3(0.35, 0.55, 1.0);
+        lines = max(lines, 1.0 - axis.x);
+    }
+    vec2 edge = min(bedPos - bedMin.xz, bedMax.xz - bedPos) / pixel;
+    lines = max(lines, 1.0 - min(min(edge.x, edge.y) * 0.5, 1.0));
+
+    if (lines < 0.01)
+        discard;
+    FragColor = vec4(color, lines);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// Corners of the bed quad come from the vertex index, there are no attributes
+
+out vec2 bedPos;
+
+uniform mat4 camMatrix;
+// Bed corners, the grid lies a hair above the bottom so it does not fight with the floor
+uniform vec3 bedMin;
+uniform vec3 bedMax;
+#include "section.glsl"
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    bedPos = mix(bedMin.xz, bedMax.xz, corner);
+    vec4 position = vec4(bedPos.x, bedMin.y + 0.001, bedPos.y, 1.0);
+    clipSections(position.xyz);
+    gl_Position = camMatrix * position;
+}
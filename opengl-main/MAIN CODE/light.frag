@@ -6,5 +6,5 @@ uniform vec4 lightColor;
 
 void main()
 {
-	FragColor = vec4(0.8f, 0.8f, 0.8f, 1.0f); 
+	FragColor = vec4(lightColor.rgb * 0.8f, 1.0f);
 }
\ No newline at end of file
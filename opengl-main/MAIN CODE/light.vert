@@ -4,8 +4,11 @@ layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
 uniform mat4 camMatrix;
+#include "section.glsl"
 
 void main()
 {
-	gl_Position = camMatrix * model * vec4(aPos, 1.0f);
+	vec4 position = model * vec4(aPos, 1.0f);
+	clipSections(position.xyz);
+	gl_Position = camMatrix * position;
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+// Section planes as (normal, distance), what lies on the negative side is cut away. Planes that are
+// not in use are left disabled on the CPU side, so whatever they hold is ignored.
+uniform vec4 sectionPlanes[3];
+out float gl_ClipDistance[3];
+
+// Writes the distances of a world position from the section planes
+void clipSections(vec3 position)
+{
+    for (int i = 0; i < 3; i++)
+        gl_ClipDistance[i] = dot(vec4(position, 1.0), sectionPlanes[i]);
+}
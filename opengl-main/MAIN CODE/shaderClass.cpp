@@ -17,12 +17,35 @@ std::string get_file_contents(const char* filename)
 	throw(errno);
 }
 
+// Reads a shader file and replaces every #include "file" line with that file's source,
+// GLSL has no includes of its own and the shaders share a few pieces
+std::string get_shader_source(const char* filename)
+{
+	std::istringstream in(get_file_contents(filename));
+	std::string source;
+	std::string line;
+	const std::string include = "#include \"";
+	while (std::getline(in, line))
+	{
+		if (line.compare(0, include.size(), include) == 0)
+		{
+			size_t end = line.find('"', include.size());
+			source += get_shader_source(line.substr(include.size(), end - include.size()).c_str());
+		}
+		else
+		{
+			source += line + "\n";
+		}
+	}
+	return source;
+}
+
 // Constructor that build the Shader Program from 2 different shaders
 Shader::Shader(const char* vertexFile, const char* fragmentFile)
 {
 	// Read vertexFile and fragmentFile and store the strings
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
+	std::string vertexCode = get_shader_source(vertexFile);
+	std::string fragmentCode = get_shader_source(fragmentFile);
 
 	// Convert the shader source strings into character arrays
 	const char* vertexSource = vertexCode.c_str();
@@ -9,6 +9,7 @@
 #include<cerrno>
 
 std::string get_file_contents(const char* filename);
+std::string get_shader_source(const char* filename);
 
 class Shader
 {
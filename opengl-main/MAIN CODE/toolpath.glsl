@@ -0,0 +1,53 @@
+// Points of the toolpath buffer, one ToolpathPoint per texel: x is position x | y << 16, y is position
+// z | layer << 16 with the top bit set on the first point of a run, z the time bits and w the bytes of
+// ToolpathAttribute. Every point ends the move from the point before it and has that move's attributes.
+uniform usamplerBuffer points;
+// Decodes the quantized positions
+uniform vec3 positionOrigin;
+uniform vec3 positionScale;
+// -1 stream color, 0 tool color, 1 speed, 2 flow, 3 layer, 4 feature, 5 fan
+uniform int colorMode;
+uniform float layerCount;
+// Colors of tools 0..15 for mode 0
+uniform vec4 toolColors[16];
+// Color of the whole stream for mode -1
+uniform vec4 streamColor;
+uniform sampler1D colorLut;
+
+vec3 pointPosition(uvec4 point)
+{
+    return positionOrigin + vec3(float(point.x & 0xffffu), float(point.x >> 16), float(point.y & 0xffffu)) * positionScale;
+}
+
+float pointTime(uvec4 point)
+{
+    return uintBitsToFloat(point.z);
+}
+
+// No move ends at the first point of a run
+bool startsRun(uvec4 point)
+{
+    return (point.y & 0x80000000u) != 0u;
+}
+
+// Color of the move that ends at point, both ends of the move share it
+vec4 moveColor(uvec4 point)
+{
+    if (colorMode < 0)
+        return streamColor;
+    uvec4 attributes = (uvec4(point.w) >> uvec4(0u, 8u, 16u, 24u)) & 0xffu;
+    if (colorMode == 0)
+        return toolColors[attributes.w & 15u];
+    float colorValue;
+    if (colorMode == 1)
+        colorValue = float(attributes.x) / 255.0;
+    else if (colorMode == 2)
+        colorValue = float(attributes.y) / 255.0;
+    else if (colorMode == 3)
+        colorValue = float((point.y >> 16) & 0x7fffu) / max(layerCount - 1.0, 1.0);
+    else if (colorMode == 4)
+        colorValue = (float(attributes.w >> 4u) + 0.5) / 16.0;
+    else
+        colorValue = float(attributes.z) / 255.0;
+    return texture(colorLut, colorValue);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// Moves of the toolpath buffer without vertex attributes, vertices 2i and 2i + 1 are the ends of the
+// move that ends at point i
+#include "toolpath.glsl"
+#include "section.glsl"
+
+out float time;
+// Color of the vertex, from the tool or the color table
+out vec4 color;
+
+uniform mat4 model;
+uniform mat4 camMatrix;
+
+void main()
+{
+    int index = gl_VertexID / 2;
+    uvec4 end = texelFetch(points, index);
+    uvec4 point = (gl_VertexID & 1) == 0 ? texelFetch(points, max(index - 1, 0)) : end;
+    time = pointTime(point);
+    color = moveColor(end);
+    vec3 position = (model * vec4(pointPosition(point), 1.0)).xyz;
+    clipSections(position);
+    gl_Position = camMatrix * vec4(position, 1.0);
+    // The vertices of a run's first point go outside the view and are clipped
+    if (startsRun(end))
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+}
@@ -1,7 +1,14 @@
 #version 330 core
 out vec4 FragColor;
 
+in float time;
+in vec4 color;
+
+uniform float currentTime; // Playback time, the toolpath past it is not printed yet
+
 void main()
 {
-    FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Red color for the trace lines
+    if (time > currentTime)
+        discard;
+    FragColor = color;
 }
@@ -1,10 +1,25 @@
 #version 330 core
+// Live trace of the jogged tools as plain floats
 layout (location = 0) in vec3 aPos;
+// Tool of the trace, a constant attribute for the whole draw
+layout (location = 1) in uint aTool;
+#include "section.glsl"
+
+out float time;
+// Color of the vertex, from the tool
+out vec4 color;
 
 uniform mat4 model;
 uniform mat4 camMatrix;
+// Colors of tools 0..15
+uniform vec4 toolColors[16];
 
 void main()
 {
-    gl_Position = camMatrix * model * vec4(aPos, 1.0);
+    // The live trace has no times, all of it is shown
+    time = 0.0;
+    color = toolColors[aTool & 15u];
+    vec3 position = (model * vec4(aPos, 1.0)).xyz;
+    clipSections(position);
+    gl_Position = camMatrix * vec4(position, 1.0);
 }
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in float time;
+in vec4 color;
+in vec3 Normal;
+
+uniform float currentTime; // Playback time, the bead past it is not printed yet
+
+// Light from above, a little from the front
+const vec3 lightDirection = normalize(vec3(0.3, 1.0, 0.5));
+
+void main()
+{
+    if (time > currentTime)
+        discard;
+    float diffuse = max(dot(normalize(Normal), lightDirection), 0.0);
+    FragColor = vec4(color.rgb * (0.35 + 0.65 * diffuse), color.a);
+}
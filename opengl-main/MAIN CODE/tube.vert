@@ -0,0 +1,58 @@
+#version 330 core
+#include "toolpath.glsl"
+#include "section.glsl"
+// Width and height of the bead of the move that ends at every point
+uniform samplerBuffer beads;
+
+// Every point draws the tube of the move that ends at it, two triangles on each side of a square,
+// as many vertices as tubeVertices in ToolpathBuffer.h
+const int tubeVertices = 24;
+// Corners of the square across the tube, y across the move and z up. The sides share them, so the
+// normals round off like a real bead.
+const vec2 corners[5] = vec2[5](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5), vec2(-0.5, 0.5), vec2(-0.5, -0.5));
+// End of the move and corner of the side every vertex of a side's two triangles takes
+const float sideEnds[6] = float[6](0.0, 1.0, 0.0, 0.0, 1.0, 1.0);
+const int sideCorners[6] = int[6](0, 0, 1, 1, 0, 1);
+
+out float time;
+out vec4 color;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 camMatrix;
+
+void main()
+{
+    int index = gl_VertexID / tubeVertices;
+    int vertex = gl_VertexID % tubeVertices;
+    // x runs 0..1 along the move, y and z -0.5..0.5 across it
+    vec3 aCorner = vec3(sideEnds[vertex % 6], corners[vertex / 6 + sideCorners[vertex % 6]]);
+    uvec4 endPoint = texelFetch(points, index);
+    uvec4 startPoint = texelFetch(points, max(index - 1, 0));
+    vec2 bead = texelFetch(beads, index).xy;
+    time = mix(pointTime(startPoint), pointTime(endPoint), aCorner.x);
+    color = moveColor(endPoint);
+
+    vec3 start = pointPosition(startPoint);
+    vec3 end = pointPosition(endPoint);
+    // Moves that quantize to a single point have no direction of their own, they become a box along X
+    float span = distance(start, end);
+    vec3 along = span > 0.0 ? (end - start) / span : vec3(1.0, 0.0, 0.0);
+    // Y is up, vertical moves take X as their side
+    vec3 side = cross(along, vec3(0.0, 1.0, 0.0));
+    side = length(side) > 1e-4 ? normalize(side) : vec3(1.0, 0.0, 0.0);
+    vec3 up = cross(side, along);
+
+    // The nozzle runs along the top of the bead, both ends reach half a width further so corners close
+    float width = bead.x;
+    float height = width > 0.0 ? bead.y : 0.0;
+    vec3 center = mix(start - along * width * 0.5, end + along * width * 0.5, aCorner.x) - vec3(0.0, height * 0.5, 0.0);
+    vec3 position = center + side * aCorner.y * width + up * aCorner.z * height;
+    Normal = side * aCorner.y + up * aCorner.z;
+    position = (model * vec4(position, 1.0)).xyz;
+    clipSections(position);
+    gl_Position = camMatrix * vec4(position, 1.0);
+    // The tube of a run's first point goes outside the view and is clipped
+    if (startsRun(endPoint))
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+}